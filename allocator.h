@@ -0,0 +1,119 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef allocator_h
+#define allocator_h
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "huge_pages.h"
+
+/** Memory management for structures.
+ *
+ * Every structure allocates all its arrays in a single arena obtained from a sux_allocator, and
+ * places each array at the start of a cache line, so that, for instance, a pair of rank9 counts
+ * never straddles two lines. Structures that own other structures (e.g., elias_fano) put the arrays
+ * of the inner structures in their own arena, too. The default allocator uses the heap (or huge
+ * pages, when compiled with -DHUGEPAGES); an arena_allocator places structures in memory reserved
+ * in advance. */
+
+#define CACHE_LINE_SIZE ( 64 )
+
+// Rounds a number of bytes to a multiple of the cache line size.
+__inline static uint64_t cache_align( const uint64_t bytes ) {
+	return ( bytes + CACHE_LINE_SIZE - 1 ) & -(uint64_t)CACHE_LINE_SIZE;
+}
+
+class sux_allocator {
+public:
+	virtual ~sux_allocator() {}
+	/** Returns zeroed memory aligned to a cache line. */
+	virtual void *allocate( const uint64_t bytes ) = 0;
+	/** Releases memory returned by allocate( bytes ). */
+	virtual void deallocate( void * const p, const uint64_t bytes ) = 0;
+};
+
+class heap_allocator : public sux_allocator {
+public:
+	void *allocate( const uint64_t bytes ) {
+#ifdef HUGEPAGES
+		if ( bytes >= HUGE_PAGE_SIZE ) return huge_pages_alloc( bytes );
+#endif
+		void *p;
+		if ( posix_memalign( &p, CACHE_LINE_SIZE, cache_align( bytes ) ) != 0 ) {
+			perror( "posix_memalign" );
+			abort();
+		}
+		memset( p, 0, bytes );
+		return p;
+	}
+
+	void deallocate( void * const p, const uint64_t bytes ) {
+#ifdef HUGEPAGES
+		if ( bytes >= HUGE_PAGE_SIZE ) {
+			huge_pages_free( p );
+			return;
+		}
+#endif
+		free( p );
+	}
+};
+
+/** Returns the allocator used by structures when none is specified. */
+__inline static sux_allocator &default_allocator() {
+	static heap_allocator allocator;
+	return allocator;
+}
+
+/** Carves consecutive, cache-line-aligned blocks out of a region of memory (which must be
+ * aligned to a cache line) without ever freeing them. Structures use it to lay out their arena,
+ * and it can be passed to a constructor to build a structure in pre-reserved memory; in the
+ * latter case, it must outlive the structure. */
+
+class arena_allocator : public sux_allocator {
+private:
+	char *next, *end;
+	bool zeroed;
+
+public:
+	arena_allocator() : next( NULL ), end( NULL ), zeroed( true ) {}
+	/** If zeroed is true, memory is known to be zeroed already. */
+	arena_allocator( void * const memory, const uint64_t bytes, const bool zeroed = false ) : next( (char *)memory ), end( (char *)memory + bytes ), zeroed( zeroed ) {}
+
+	void *allocate( const uint64_t bytes ) {
+		const uint64_t length = cache_align( bytes );
+		if ( length > (uint64_t)( end - next ) ) {
+			fprintf( stderr, "arena_allocator: requested %lld bytes, %lld available\n", (long long)length, (long long)( end - next ) );
+			abort();
+		}
+		void * const p = next;
+		next += length;
+		if ( ! zeroed ) memset( p, 0, bytes );
+		return p;
+	}
+
+	void deallocate( void * const p, const uint64_t bytes ) {}
+
+	/** Returns the number of bytes still available. */
+	uint64_t available() { return end - next; }
+};
+
+#endif
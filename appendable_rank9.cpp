@@ -0,0 +1,99 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <sys/mman.h>
+#include "appendable_rank9.h"
+
+// Maps zero-filled memory that is backed by pages only when written.
+static uint64_t *reserve( const uint64_t length ) {
+	void * const p = mmap( NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+	if ( p == MAP_FAILED ) {
+		perror( "mmap" );
+		abort();
+	}
+	return (uint64_t *)p;
+}
+
+appendable_rank9::appendable_rank9( const uint64_t max_bits ) {
+	max_words = ( max_bits + 63 ) / 64;
+	written = num_words = num_ones = 0;
+	// One more word for rank( size() ), and counts for one more block.
+	bits_length = ( max_words + 1 ) * sizeof *bits;
+	counts_length = ( ( max_words + 7 ) / 8 + 1 ) * 2 * sizeof *counts;
+	bits = reserve( bits_length );
+	counts = reserve( counts_length );
+}
+
+appendable_rank9::~appendable_rank9() {
+	munmap( bits, bits_length );
+	munmap( counts, counts_length );
+}
+
+// Stores a word and the counts needed to rank up to the end of it, without publishing it.
+__inline void appendable_rank9::write( const uint64_t word ) {
+	const uint64_t i = written;
+	if ( i == max_words ) {
+		fprintf( stderr, "appendable_rank9: more than %lld words\n", (long long)max_words );
+		abort();
+	}
+
+	bits[ i ] = word;
+	num_ones += __builtin_popcountll( word );
+	const uint64_t block = i / 8 * 2;
+	// Readers might be reading the relative counts of the current block: we store them atomically.
+	if ( i % 8 != 7 ) __atomic_store_n( &counts[ block + 1 ], counts[ block + 1 ] | ( num_ones - counts[ block ] ) << 9 * ( i % 8 ), __ATOMIC_RELAXED );
+	else counts[ block + 2 ] = num_ones;
+	written = i + 1;
+}
+
+void appendable_rank9::push_back( const uint64_t word ) {
+	write( word );
+	__atomic_store_n( &num_words, written, __ATOMIC_RELEASE );
+}
+
+void appendable_rank9::append( const uint64_t * const words, const uint64_t n ) {
+	for( uint64_t i = 0; i < n; i++ ) write( words[ i ] );
+	__atomic_store_n( &num_words, written, __ATOMIC_RELEASE );
+}
+
+uint64_t appendable_rank9::size() {
+	return __atomic_load_n( &num_words, __ATOMIC_ACQUIRE ) * 64;
+}
+
+MULTIVERSION uint64_t appendable_rank9::rank( const uint64_t k ) {
+	const uint64_t word = k / 64;
+	const uint64_t block = word / 4 & ~1;
+	const int offset = word % 8 - 1;
+	const uint64_t rank = counts[ block ] + ( __atomic_load_n( &counts[ block + 1 ], __ATOMIC_RELAXED ) >> ( offset + ( offset >> sizeof offset * 8 - 4 & 0x8 ) ) * 9 & 0x1FF );
+	// For k == size() the word at k / 64 might be being written: we must not touch it.
+	if ( k % 64 == 0 ) return rank;
+	return rank + __builtin_popcountll( bits[ word ] & ( ( 1ULL << k % 64 ) - 1 ) );
+}
+
+bool appendable_rank9::get( const uint64_t k ) {
+	return bits[ k / 64 ] >> k % 64 & 1;
+}
+
+uint64_t appendable_rank9::bit_count() {
+	return ( written + 7 ) / 8 * 2 * 64;
+}
@@ -0,0 +1,60 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef appendable_rank9_h
+#define appendable_rank9_h
+#include <stdint.h>
+#include "macros.h"
+
+/** A rank9 structure on a bit vector that grows at the end, one word at a time.
+ *
+ * Each appended word updates the counts in constant time. Bits and counts are stored in
+ * anonymous mappings reserving room for max_bits bits, which are backed by memory only as they
+ * are written, and never move. A single writer may append while other threads query: size() is
+ * published after the words and counts it covers, so readers always see a consistent prefix. */
+
+class appendable_rank9 {
+private:
+	uint64_t *bits, *counts;
+	uint64_t max_words, num_ones;
+	uint64_t written; // Words stored by the writer
+	uint64_t num_words; // Words visible to readers, published with release semantics
+	uint64_t bits_length, counts_length;
+
+	void write( const uint64_t word );
+
+public:
+	/** Reserves room for max_bits bits. */
+	appendable_rank9( const uint64_t max_bits );
+	~appendable_rank9();
+	/** Appends a word (writer only). */
+	void push_back( const uint64_t word );
+	/** Appends n words, making them visible to readers all at once (writer only). */
+	void append( const uint64_t * const words, const uint64_t n );
+	/** Returns the number of bits that readers can query (a multiple of 64). */
+	uint64_t size();
+	/** Returns the number of ones before pos, which must not exceed a value returned by size(). */
+	uint64_t rank( const uint64_t pos );
+	bool get( const uint64_t pos );
+	// Just for analysis purposes
+	uint64_t bit_count();
+};
+
+#endif
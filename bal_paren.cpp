@@ -31,6 +31,7 @@ using namespace std;
 bal_paren::bal_paren() {}
 
 bal_paren::bal_paren( const uint64_t * const bits, const uint64_t num_bits ) {
+	mapped = false;
 	this->bits = bits;
 	num_words = ( num_bits + 63 ) / 64;
 
@@ -92,6 +93,7 @@ bal_paren::bal_paren( const uint64_t * const bits, const uint64_t num_bits ) {
 	for( uint64_t i = 0; i < opening_pioneers.size(); i++ ) set( opening_pioneers_bits, opening_pioneers[ i ] );
 	opening_pioneers_rank = new rank9( opening_pioneers_bits, num_bits );
 
+	num_pioneers = opening_pioneers.size();
 	reverse(opening_pioneers.begin(), opening_pioneers.end());
 	this->opening_pioneers = new uint64_t[ opening_pioneers.size() ];
 	copy(opening_pioneers.begin(), opening_pioneers.end(), this->opening_pioneers );
@@ -122,13 +124,39 @@ bal_paren::bal_paren( const uint64_t * const bits, const uint64_t num_bits ) {
 }
 
 bal_paren::~bal_paren() {
-	delete [] opening_pioneers;
-	delete [] opening_pioneers_matches;
+	if ( ! mapped ) {
+		delete [] opening_pioneers;
+		delete [] opening_pioneers_matches;
+		delete [] opening_pioneers_bits;
+	}
+	delete opening_pioneers_rank;
+}
+
+bal_paren::bal_paren( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "bal_paren" );
+	num_words = reader.scalar();
+	num_pioneers = reader.scalar();
+	opening_pioneers_bits = reader.array<uint64_t>( num_words );
+	opening_pioneers = reader.array<uint64_t>( num_pioneers );
+	opening_pioneers_matches = reader.array<uint64_t>( num_pioneers );
+	opening_pioneers_rank = new rank9( opening_pioneers_bits, reader );
+}
+
+void bal_paren::save( sux_writer &writer ) {
+	writer.header( "bal_paren" );
+	writer.scalar( num_words );
+	writer.scalar( num_pioneers );
+	writer.array( opening_pioneers_bits, num_words );
+	writer.array( opening_pioneers, num_pioneers );
+	writer.array( opening_pioneers_matches, num_pioneers );
+	opening_pioneers_rank->save( writer );
 }
 
 long long far_find_close;
 
-uint64_t bal_paren::find_close( const uint64_t pos ) {
+MULTIVERSION uint64_t bal_paren::find_close( const uint64_t pos ) {
 		const int word = (int)( pos / 64 );
 		const int bit = (int)( pos & 63 );
 		assert( ( bits[ word ] & 1ULL << bit ) != 0 );
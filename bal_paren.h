@@ -25,13 +25,15 @@
 #include "elias_fano.h"
 #include "rank9.h"
 #include "tables.h"
+#include "serialize.h"
 
 class bal_paren {
 private:
 	const uint64_t *bits;
 	uint64_t *opening_pioneers, *opening_pioneers_bits, *opening_pioneers_matches;
 	rank9 *opening_pioneers_rank;
-	uint64_t num_words;
+	uint64_t num_words, num_pioneers;
+	bool mapped;
 
 	__inline static void set( uint64_t * const bits, const uint64_t pos ) {
 		bits[ pos / 64 ] |= 1ULL << pos % 64;
@@ -295,6 +297,8 @@ public:
 	bal_paren();
 	bal_paren( const uint64_t * const bits, const uint64_t num_bits );
 	~bal_paren();
+	bal_paren( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t find_close( const uint64_t pos );
 	// Just for analysis purposes
 	void print_counts();
@@ -0,0 +1,449 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "dynamic_bit_vector.h"
+#include "popcount.h"
+#include "select.h"
+
+using namespace std;
+
+#define LEAF_WORDS (32)
+#define LEAF_BITS (LEAF_WORDS * 64)
+#define MIN_LEAF_BITS (LEAF_BITS / 4)
+#define MAX_CHILDREN (16)
+#define MIN_CHILDREN (MAX_CHILDREN / 4)
+// Leaves and nodes built from a static bit vector are filled to this fraction of their capacity.
+#define BUILD_LEAF_BITS (LEAF_BITS / 4 * 3)
+#define BUILD_CHILDREN (MAX_CHILDREN / 4 * 3)
+
+// A leaf is an array of LEAF_WORDS + 1 words: the last one is always zero, so rank can read one word past the end.
+// Bits beyond the size of a leaf are always zero.
+
+struct dynamic_bit_vector::node {
+	bool leaves; // Whether the children are leaves
+	int num_children;
+	// Number of bits and ones of each child; there is room for one more child before a split.
+	uint64_t sizes[ MAX_CHILDREN + 1 ], ones[ MAX_CHILDREN + 1 ];
+	void *children[ MAX_CHILDREN + 1 ];
+
+	node( const bool leaves ) : leaves( leaves ), num_children( 0 ) {}
+
+	void insert_child( const int i, void * const child, const uint64_t size, const uint64_t num_ones ) {
+		for( int j = num_children; j > i; j-- ) {
+			sizes[ j ] = sizes[ j - 1 ];
+			ones[ j ] = ones[ j - 1 ];
+			children[ j ] = children[ j - 1 ];
+		}
+		sizes[ i ] = size;
+		ones[ i ] = num_ones;
+		children[ i ] = child;
+		num_children++;
+	}
+
+	void remove_child( const int i ) {
+		num_children--;
+		for( int j = i; j < num_children; j++ ) {
+			sizes[ j ] = sizes[ j + 1 ];
+			ones[ j ] = ones[ j + 1 ];
+			children[ j ] = children[ j + 1 ];
+		}
+	}
+
+	// Moves the children from position from onwards to the end of n.
+	void move_children( const int from, node * const n ) {
+		for( int j = from; j < num_children; j++ ) n->insert_child( n->num_children, children[ j ], sizes[ j ], ones[ j ] );
+		num_children = from;
+	}
+
+	uint64_t total_size() {
+		uint64_t s = 0;
+		for( int j = 0; j < num_children; j++ ) s += sizes[ j ];
+		return s;
+	}
+
+	uint64_t total_ones() {
+		uint64_t s = 0;
+		for( int j = 0; j < num_children; j++ ) s += ones[ j ];
+		return s;
+	}
+};
+
+__inline static uint64_t *new_leaf() {
+	return new uint64_t[ LEAF_WORDS + 1 ]();
+}
+
+// Inserts a bit in a leaf of size bits (less than LEAF_BITS).
+__inline static void leaf_insert( uint64_t * const words, const uint64_t size, const uint64_t pos, const bool value ) {
+	const uint64_t w = pos / 64;
+	const uint64_t mask = ( 1ULL << pos % 64 ) - 1;
+	for( uint64_t k = size / 64; k > w; k-- ) words[ k ] = words[ k ] << 1 | words[ k - 1 ] >> 63;
+	words[ w ] = ( words[ w ] & mask ) | ( words[ w ] & ~mask ) << 1 | (uint64_t)value << pos % 64;
+}
+
+// Deletes a bit from a leaf of size bits, and returns it.
+__inline static bool leaf_erase( uint64_t * const words, const uint64_t size, const uint64_t pos ) {
+	const uint64_t w = pos / 64;
+	const uint64_t mask = ( 1ULL << pos % 64 ) - 1;
+	const bool bit = words[ w ] >> pos % 64 & 1;
+	words[ w ] = ( words[ w ] & mask ) | ( words[ w ] >> 1 & ~mask );
+	for( uint64_t k = w; k < ( size - 1 ) / 64; k++ ) {
+		words[ k ] |= words[ k + 1 ] << 63;
+		words[ k + 1 ] >>= 1;
+	}
+	return bit;
+}
+
+// Returns width bits (0 < width <= 64) starting at position start.
+__inline static uint64_t get_bits( const uint64_t * const words, const uint64_t start, const int width ) {
+	const int offset = start % 64;
+	uint64_t x = words[ start / 64 ] >> offset;
+	if ( offset != 0 && offset + width > 64 ) x |= words[ start / 64 + 1 ] << 64 - offset;
+	return width == 64 ? x : x & ( 1ULL << width ) - 1;
+}
+
+// Copies n bits starting at position from of src to position to of dst, where all bits are zero.
+static void copy_bits( uint64_t * const dst, const uint64_t to, const uint64_t * const src, const uint64_t from, const uint64_t n ) {
+	for( uint64_t k = 0; k < n; k += 64 ) {
+		const int width = min( (uint64_t)64, n - k );
+		const uint64_t x = get_bits( src, from + k, width );
+		const uint64_t p = to + k;
+		dst[ p / 64 ] |= x << p % 64;
+		if ( p % 64 != 0 && p % 64 + width > 64 ) dst[ p / 64 + 1 ] |= x >> 64 - p % 64;
+	}
+}
+
+dynamic_bit_vector::dynamic_bit_vector() {
+	num_bits = num_ones = 0;
+	root = new node( true );
+	root->insert_child( 0, new_leaf(), 0, 0 );
+}
+
+dynamic_bit_vector::dynamic_bit_vector( const uint64_t * const bits, const uint64_t num_bits ) {
+	this->num_bits = num_bits;
+	// Leaves are filled to BUILD_LEAF_BITS, but a short last leaf is merged with the previous one.
+	uint64_t num_leaves = max( (uint64_t)1, ( num_bits + BUILD_LEAF_BITS - 1 ) / BUILD_LEAF_BITS );
+	if ( num_leaves > 1 && num_bits - ( num_leaves - 1 ) * BUILD_LEAF_BITS < MIN_LEAF_BITS ) num_leaves--;
+
+	vector<void *> level( num_leaves );
+	vector<uint64_t> sizes( num_leaves ), ones( num_leaves );
+	num_ones = 0;
+
+	for( uint64_t l = 0; l < num_leaves; l++ ) {
+		const uint64_t start = l * BUILD_LEAF_BITS;
+		const uint64_t size = l == num_leaves - 1 ? num_bits - start : BUILD_LEAF_BITS;
+		uint64_t * const leaf = new_leaf();
+		memcpy( leaf, bits + start / 64, ( size + 63 ) / 64 * sizeof *leaf );
+		if ( size % 64 != 0 ) leaf[ size / 64 ] &= ( 1ULL << size % 64 ) - 1;
+		level[ l ] = leaf;
+		sizes[ l ] = size;
+		ones[ l ] = count_ones( leaf, LEAF_WORDS );
+		num_ones += ones[ l ];
+	}
+
+	// Each level groups the previous one into nodes of about BUILD_CHILDREN children.
+	bool leaves = true;
+	do {
+		const uint64_t n = level.size(), num_nodes = ( n + BUILD_CHILDREN - 1 ) / BUILD_CHILDREN;
+		vector<void *> next( num_nodes );
+		vector<uint64_t> next_sizes( num_nodes ), next_ones( num_nodes );
+
+		for( uint64_t k = 0, j = 0; k < num_nodes; k++ ) {
+			node * const p = new node( leaves );
+			// Children are evenly distributed among nodes.
+			for( const uint64_t end = n * ( k + 1 ) / num_nodes; j < end; j++ ) p->insert_child( p->num_children, level[ j ], sizes[ j ], ones[ j ] );
+			next[ k ] = p;
+			next_sizes[ k ] = p->total_size();
+			next_ones[ k ] = p->total_ones();
+		}
+
+		level.swap( next );
+		sizes.swap( next_sizes );
+		ones.swap( next_ones );
+		leaves = false;
+	} while( level.size() > 1 );
+
+	root = (node *)level[ 0 ];
+}
+
+dynamic_bit_vector::~dynamic_bit_vector() {
+	free( root );
+}
+
+void dynamic_bit_vector::free( node * const n ) {
+	for( int i = 0; i < n->num_children; i++ ) {
+		if ( n->leaves ) delete [] (uint64_t *)n->children[ i ];
+		else free( (node *)n->children[ i ] );
+	}
+	delete n;
+}
+
+uint64_t dynamic_bit_vector::size() {
+	return num_bits;
+}
+
+uint64_t dynamic_bit_vector::count() {
+	return num_ones;
+}
+
+bool dynamic_bit_vector::get( uint64_t pos ) {
+	assert( pos < num_bits );
+	for( node *n = root;; ) {
+		int i = 0;
+		while( pos >= n->sizes[ i ] ) pos -= n->sizes[ i++ ];
+		if ( n->leaves ) return ( (uint64_t *)n->children[ i ] )[ pos / 64 ] >> pos % 64 & 1;
+		n = (node *)n->children[ i ];
+	}
+}
+
+MULTIVERSION uint64_t dynamic_bit_vector::rank( uint64_t pos ) {
+	assert( pos <= num_bits );
+	uint64_t r = 0;
+	for( node *n = root;; ) {
+		int i = 0;
+		while( i < n->num_children - 1 && pos >= n->sizes[ i ] ) {
+			pos -= n->sizes[ i ];
+			r += n->ones[ i++ ];
+		}
+
+		if ( n->leaves ) {
+			const uint64_t * const leaf = (uint64_t *)n->children[ i ];
+			for( uint64_t w = 0; w < pos / 64; w++ ) r += __builtin_popcountll( leaf[ w ] );
+			return r + __builtin_popcountll( leaf[ pos / 64 ] & ( 1ULL << pos % 64 ) - 1 );
+		}
+
+		n = (node *)n->children[ i ];
+	}
+}
+
+MULTIVERSION uint64_t dynamic_bit_vector::select( uint64_t rank ) {
+	assert( rank < num_ones );
+	uint64_t pos = 0;
+	for( node *n = root;; ) {
+		int i = 0;
+		while( rank >= n->ones[ i ] ) {
+			rank -= n->ones[ i ];
+			pos += n->sizes[ i++ ];
+		}
+
+		if ( n->leaves ) {
+			const uint64_t * const leaf = (uint64_t *)n->children[ i ];
+			for( int w = 0;; w++ ) {
+				const uint64_t ones = __builtin_popcountll( leaf[ w ] );
+				if ( rank < ones ) return pos + w * 64 + select_in_word( leaf[ w ], rank );
+				rank -= ones;
+			}
+		}
+
+		n = (node *)n->children[ i ];
+	}
+}
+
+bool dynamic_bit_vector::set( const uint64_t pos, const bool value ) {
+	assert( pos < num_bits );
+	const bool old = set( root, pos, value );
+	num_ones += (int)value - (int)old;
+	return old;
+}
+
+bool dynamic_bit_vector::clear( const uint64_t pos ) {
+	return set( pos, false );
+}
+
+bool dynamic_bit_vector::set( node * const n, uint64_t pos, const bool value ) {
+	int i = 0;
+	while( pos >= n->sizes[ i ] ) pos -= n->sizes[ i++ ];
+	bool old;
+
+	if ( n->leaves ) {
+		uint64_t * const leaf = (uint64_t *)n->children[ i ];
+		old = leaf[ pos / 64 ] >> pos % 64 & 1;
+		leaf[ pos / 64 ] = leaf[ pos / 64 ] & ~( 1ULL << pos % 64 ) | (uint64_t)value << pos % 64;
+	}
+	else old = set( (node *)n->children[ i ], pos, value );
+
+	n->ones[ i ] += (int)value - (int)old;
+	return old;
+}
+
+void dynamic_bit_vector::insert( const uint64_t pos, const bool value ) {
+	assert( pos <= num_bits );
+	node * const sibling = insert( root, pos, value );
+	if ( sibling != NULL ) {
+		// The root was split: the tree grows by one level.
+		node * const new_root = new node( false );
+		new_root->insert_child( 0, root, root->total_size(), root->total_ones() );
+		new_root->insert_child( 1, sibling, sibling->total_size(), sibling->total_ones() );
+		root = new_root;
+	}
+	num_bits++;
+	num_ones += value;
+}
+
+// Inserts a bit in the subtree rooted at n; returns the new right sibling of n if n had to be split.
+dynamic_bit_vector::node *dynamic_bit_vector::insert( node * const n, uint64_t pos, const bool value ) {
+	int i = 0;
+	// We prefer appending to a child to prepending to the next one.
+	while( i < n->num_children - 1 && pos > n->sizes[ i ] ) pos -= n->sizes[ i++ ];
+
+	if ( n->leaves ) {
+		uint64_t *leaf = (uint64_t *)n->children[ i ];
+		if ( n->sizes[ i ] == LEAF_BITS ) {
+			// The leaf is full: its second half moves to a new leaf.
+			uint64_t * const right = new_leaf();
+			memcpy( right, leaf + LEAF_WORDS / 2, LEAF_WORDS / 2 * sizeof *leaf );
+			memset( leaf + LEAF_WORDS / 2, 0, LEAF_WORDS / 2 * sizeof *leaf );
+			const uint64_t right_ones = count_ones( right, LEAF_WORDS / 2 );
+			n->sizes[ i ] = LEAF_BITS / 2;
+			n->ones[ i ] -= right_ones;
+			n->insert_child( i + 1, right, LEAF_BITS / 2, right_ones );
+			if ( pos > LEAF_BITS / 2 ) {
+				pos -= LEAF_BITS / 2;
+				leaf = right;
+				i++;
+			}
+		}
+
+		leaf_insert( leaf, n->sizes[ i ], pos, value );
+	}
+	else {
+		node * const child = (node *)n->children[ i ];
+		node * const sibling = insert( child, pos, value );
+		if ( sibling != NULL ) {
+			const uint64_t size = sibling->total_size(), ones = sibling->total_ones();
+			n->sizes[ i ] -= size;
+			n->ones[ i ] -= ones;
+			n->insert_child( i + 1, sibling, size, ones );
+		}
+	}
+
+	n->sizes[ i ]++;
+	n->ones[ i ] += value;
+	if ( n->num_children <= MAX_CHILDREN ) return NULL;
+
+	node * const right = new node( n->leaves );
+	n->move_children( n->num_children / 2, right );
+	return right;
+}
+
+bool dynamic_bit_vector::erase( const uint64_t pos ) {
+	assert( pos < num_bits );
+	const bool bit = erase( root, pos );
+	if ( ! root->leaves && root->num_children == 1 ) {
+		// The root has a single child: the tree shrinks by one level.
+		node * const child = (node *)root->children[ 0 ];
+		delete root;
+		root = child;
+	}
+	num_bits--;
+	num_ones -= bit;
+	return bit;
+}
+
+bool dynamic_bit_vector::erase( node * const n, uint64_t pos ) {
+	int i = 0;
+	while( pos >= n->sizes[ i ] ) pos -= n->sizes[ i++ ];
+
+	const bool bit = n->leaves ? leaf_erase( (uint64_t *)n->children[ i ], n->sizes[ i ], pos ) : erase( (node *)n->children[ i ], pos );
+	n->sizes[ i ]--;
+	n->ones[ i ] -= bit;
+
+	if ( n->num_children > 1 && ( n->leaves ? n->sizes[ i ] < MIN_LEAF_BITS : ( (node *)n->children[ i ] )->num_children < MIN_CHILDREN ) ) rebalance( n, i );
+	return bit;
+}
+
+// Merges the underfull child i of n with a sibling, or evens out their content.
+void dynamic_bit_vector::rebalance( node * const n, const int i ) {
+	const int a = i + 1 < n->num_children ? i : i - 1, b = a + 1;
+
+	if ( n->leaves ) {
+		uint64_t * const left = (uint64_t *)n->children[ a ], * const right = (uint64_t *)n->children[ b ];
+		const uint64_t total = n->sizes[ a ] + n->sizes[ b ], total_ones = n->ones[ a ] + n->ones[ b ];
+		uint64_t both[ 2 * LEAF_WORDS + 1 ] = {};
+		memcpy( both, left, LEAF_WORDS * sizeof *left );
+		copy_bits( both, n->sizes[ a ], right, 0, n->sizes[ b ] );
+
+		if ( total <= BUILD_LEAF_BITS ) {
+			memcpy( left, both, LEAF_WORDS * sizeof *left );
+			delete [] right;
+			n->remove_child( b );
+			n->sizes[ a ] = total;
+			n->ones[ a ] = total_ones;
+		}
+		else {
+			// The left leaf gets a whole number of words.
+			const uint64_t left_size = total / 2 & ~63ULL;
+			memset( left, 0, LEAF_WORDS * sizeof *left );
+			memset( right, 0, LEAF_WORDS * sizeof *right );
+			memcpy( left, both, left_size / 8 );
+			copy_bits( right, 0, both, left_size, total - left_size );
+			n->sizes[ a ] = left_size;
+			n->ones[ a ] = count_ones( left, LEAF_WORDS );
+			n->sizes[ b ] = total - left_size;
+			n->ones[ b ] = total_ones - n->ones[ a ];
+		}
+	}
+	else {
+		node * const left = (node *)n->children[ a ], * const right = (node *)n->children[ b ];
+		if ( left->num_children + right->num_children <= BUILD_CHILDREN ) {
+			right->move_children( 0, left );
+			delete right;
+			n->remove_child( b );
+		}
+		else {
+			const int total = left->num_children + right->num_children;
+			if ( left->num_children > total / 2 ) {
+				// Move the last children of left to the start of right.
+				node * const moved = new node( left->leaves );
+				left->move_children( total / 2, moved );
+				right->move_children( 0, moved );
+				moved->move_children( 0, right );
+				delete moved;
+			}
+			else {
+				node * const rest = new node( right->leaves );
+				right->move_children( total / 2 - left->num_children, rest );
+				right->move_children( 0, left );
+				rest->move_children( 0, right );
+				delete rest;
+			}
+			n->sizes[ b ] = right->total_size();
+			n->ones[ b ] = right->total_ones();
+		}
+		n->sizes[ a ] = left->total_size();
+		n->ones[ a ] = left->total_ones();
+	}
+}
+
+uint64_t dynamic_bit_vector::bit_count() {
+	return bit_count( root );
+}
+
+uint64_t dynamic_bit_vector::bit_count( node * const n ) {
+	uint64_t c = sizeof *n * 8;
+	for( int i = 0; i < n->num_children; i++ ) c += n->leaves ? ( LEAF_WORDS + 1 ) * 64 : bit_count( (node *)n->children[ i ] );
+	return c;
+}
+
+void dynamic_bit_vector::print_counts() {}
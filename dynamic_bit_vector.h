@@ -0,0 +1,73 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef dynamic_bit_vector_h
+#define dynamic_bit_vector_h
+#include <stdint.h>
+#include "macros.h"
+
+/** A bit vector supporting changes, insertions and deletions, besides ranking and selection,
+ * in logarithmic time.
+ *
+ * Bits are stored in leaves of 2048 bits at most, which are the children of a B-tree with at
+ * most 16 children per node. Each node stores the number of bits and ones of each of its
+ * children, so that ranking and selection descend from the root to a leaf in a single pass; at the
+ * leaves, we resort to popcounts and select_in_word(). Leaves and nodes with less than 1/4 of their
+ * capacity are merged with, or share their content with, a sibling. */
+
+class dynamic_bit_vector {
+private:
+	struct node;
+	node *root;
+	uint64_t num_bits, num_ones;
+
+	node *insert( node * const n, uint64_t pos, const bool value );
+	bool erase( node * const n, uint64_t pos );
+	bool set( node * const n, uint64_t pos, const bool value );
+	void rebalance( node * const n, const int i );
+	void free( node * const n );
+	uint64_t bit_count( node * const n );
+
+public:
+	dynamic_bit_vector();
+	/** Builds a dynamic bit vector containing a copy of the given bits. */
+	dynamic_bit_vector( const uint64_t * const bits, const uint64_t num_bits );
+	~dynamic_bit_vector();
+	/** Returns the number of bits. */
+	uint64_t size();
+	/** Returns the number of ones. */
+	uint64_t count();
+	bool get( const uint64_t pos );
+	/** Sets the bit at position pos to value; returns the previous value. */
+	bool set( const uint64_t pos, const bool value = true );
+	/** Clears the bit at position pos; returns the previous value. */
+	bool clear( const uint64_t pos );
+	/** Inserts a bit before position pos (which might be equal to size()). */
+	void insert( const uint64_t pos, const bool value );
+	/** Deletes the bit at position pos, and returns it. */
+	bool erase( const uint64_t pos );
+	uint64_t rank( const uint64_t pos );
+	uint64_t select( const uint64_t rank );
+	// Just for analysis purposes
+	void print_counts();
+	uint64_t bit_count();
+};
+
+#endif
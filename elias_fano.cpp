@@ -24,48 +24,61 @@
 #include <cstring>
 #include <climits>
 #include <algorithm>
+#include "popcount.h"
 #include "elias_fano.h"
-
-elias_fano::elias_fano( const uint64_t * const bits, const uint64_t num_bits ) {
-	const uint64_t num_words = ( num_bits + 63 ) / 64;
-	uint64_t m = 0;
-	for( uint64_t i = num_words; i-- != 0; ) m += __builtin_popcountll( bits[ i ] );
-	num_ones = m;
+#include "inventory_builder.h"
+
+// Cursor moves up to this number of values forward are performed by scanning the upper bits.
+#define MAX_CURSOR_SCAN (256)
+// Cursor skips up to this number of buckets forward are performed by calling next().
+#define MAX_CURSOR_SCAN_BUCKETS (8)
+
+// Computes l and allocates the arena for num_ones values smaller than num_bits; lower and upper bits are carved out of it.
+void elias_fano::init( const uint64_t num_ones, const uint64_t num_bits, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
+	this->num_ones = num_ones;
 	this->num_bits = num_bits;
-	l = num_ones == 0 ? 0 : max( 0, msb( num_bits / num_ones ) );
+	// An empty list gets the largest possible l, so that upper bits do not depend on the universe.
+	l = max( 0, msb( num_bits / max( num_ones, (uint64_t)1 ) ) );
 
 	printf( "Number of ones: %lld l: %d\n", num_ones, l );
 	printf( "Upper bits: %lld\n", num_ones + ( num_bits >> l ) + 1 );
 	printf( "Lower bits: %lld\n", num_ones * l );
 
-	const uint64_t lower_bits_mask = ( 1ULL << l ) - 1;
-
-	lower_bits = new uint64_t[ ( num_ones * l + 63  ) / 64 + 2 * ( l == 0 ) ];
-	upper_bits = new uint64_t[ ( ( num_ones + ( num_bits >> l ) + 1 ) + 63 ) / 64 ]();
-
-	uint64_t pos = 0;
-	for( uint64_t i = 0; i < num_bits; i++ ) {
-		if ( bits[ i / 64 ] & ( 1ULL << i % 64 ) ) {
-			if ( l != 0 ) set_bits( lower_bits, pos * l, l, i & lower_bits_mask );
-			set( upper_bits, ( i >> l ) + pos );
-			pos++;
-		}
-	}
+	lower_l_bits_mask = ( 1ULL << l ) - 1;
 
+	const uint64_t lower_bytes = ( ( num_ones * l + 63  ) / 64 + 2 * ( l == 0 ) ) * sizeof *lower_bits;
+	const uint64_t upper_bytes = ( ( num_ones + ( num_bits >> l ) + 1 ) + 63 ) / 64 * sizeof *upper_bits;
+	// The upper bits contain num_ones ones and num_bits >> l zeroes.
+	arena_bytes = cache_align( lower_bytes ) + cache_align( upper_bytes ) + cache_align( simple_select_half::allocation_size( num_ones ) ) + cache_align( simple_select_zero_half::allocation_size( num_bits >> l ) );
+	arena = allocator.allocate( arena_bytes );
+	nested = arena_allocator( arena, arena_bytes, true );
+	lower_bits = (uint64_t *)nested.allocate( lower_bytes );
+	upper_bits = (uint64_t *)nested.allocate( upper_bytes );
+}
 
+// Builds the selection structures on the upper bits and the broadword parameters.
+void elias_fano::build() {
 #ifdef DEBUG
 	printf("First lower: %016llx %016llx %016llx %016llx\n", lower_bits[ 0 ], lower_bits[ 1 ], lower_bits[ 2 ], lower_bits[ 3 ] );
 	printf("First upper: %016llx %016llx %016llx %016llx\n", upper_bits[ 0 ], upper_bits[ 1 ], upper_bits[ 2 ], upper_bits[ 3 ] );
 #endif
 
-	select_upper = new simple_select_half( upper_bits, num_ones + ( num_bits >> l ) );
-	selectz_upper = new simple_select_zero_half( upper_bits, num_ones + ( num_bits >> l ) );
+	select_upper = new simple_select_half( upper_bits, num_ones + ( num_bits >> l ), nested );
+	selectz_upper = new simple_select_zero_half( upper_bits, num_ones + ( num_bits >> l ), nested );
+	assert( nested.available() == 0 );
+
+	init_broadword();
+	printf( "Block size: %d\n", block_size );
+}
 
+// Computes the parameters of the broadword rank (see PARSEARCH) from l.
+void elias_fano::init_broadword() {
 	block_size = 0;
 	while( ++block_size * l + block_size <= 64 && block_size <= l );
 	block_size--;
 
-	printf( "Block size: %d\n", block_size );
 	block_size_mask = ( 1ULL << block_size ) - 1;
 	block_length = block_size * l;
 	block_length_mask = block_length - 1;
@@ -76,8 +89,21 @@ elias_fano::elias_fano( const uint64_t * const bits, const uint64_t num_bits ) {
 
 	compressor = 0;
 	for( int i = 0; i < block_size; i++) compressor |= 1ULL << ( l - 1 ) * i + block_size;
-	
-	lower_l_bits_mask = ( 1ULL << l ) - 1;
+}
+
+elias_fano::elias_fano( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	const uint64_t num_words = ( num_bits + 63 ) / 64;
+	init( count_ones( bits, num_words ), num_bits, allocator );
+
+	uint64_t pos = 0;
+	for_each_one<false>( bits, num_bits, 0, num_words, [&]( const uint64_t i ) {
+		if ( l != 0 ) set_bits( lower_bits, pos * l, l, i & lower_l_bits_mask );
+		set( upper_bits, ( i >> l ) + pos );
+		pos++;
+	} );
+
+	assert( pos == num_ones );
+	build();
 
 #ifndef NDEBUG
 	uint64_t r, t;
@@ -103,14 +129,66 @@ elias_fano::elias_fano( const uint64_t * const bits, const uint64_t num_bits ) {
 #endif
 }
 
+elias_fano::elias_fano( const uint64_t * const values, const uint64_t num_values, const uint64_t universe, sux_allocator &allocator ) {
+	init( num_values, universe, allocator );
+
+	for( uint64_t i = 0; i < num_values; i++ ) {
+		assert( values[ i ] < universe );
+		assert( i == 0 || values[ i - 1 ] <= values[ i ] );
+		if ( l != 0 ) set_bits( lower_bits, i * l, l, values[ i ] & lower_l_bits_mask );
+		set( upper_bits, ( values[ i ] >> l ) + i );
+	}
+
+	build();
+
+#ifndef NDEBUG
+	// Values might be repeated, and the universe might be huge: we check only positions of values.
+	uint64_t r, t;
+	for( uint64_t i = 0; i < num_values; i++ ) {
+		t = select( i );
+		r = rank( t );
+		if ( t != values[ i ] || r > i || r != 0 && values[ r - 1 ] == t ) {
+			printf( "i: %lld v: %lld s: %lld r: %lld\n", i, values[ i ], t, r );
+			assert( t == values[ i ] );
+			assert( r <= i );
+			assert( r == 0 || values[ r - 1 ] != t );
+		}
+	}
+#endif
+}
+
 elias_fano::~elias_fano() {
-	delete [] upper_bits;
-	delete [] lower_bits;
 	delete select_upper;
 	delete selectz_upper;
+	if ( ! mapped ) allocator->deallocate( arena, arena_bytes );
 }
 
-uint64_t elias_fano::rank( const uint64_t k ) {
+elias_fano::elias_fano( sux_reader &reader ) {
+	mapped = true;
+	reader.header( "elias_fano" );
+	num_bits = reader.scalar();
+	num_ones = reader.scalar();
+	l = reader.scalar();
+	lower_l_bits_mask = ( 1ULL << l ) - 1;
+	lower_bits = reader.array<uint64_t>( ( num_ones * l + 63  ) / 64 + 2 * ( l == 0 ) );
+	upper_bits = reader.array<uint64_t>( ( ( num_ones + ( num_bits >> l ) + 1 ) + 63 ) / 64 );
+	select_upper = new simple_select_half( upper_bits, reader );
+	selectz_upper = new simple_select_zero_half( upper_bits, reader );
+	init_broadword();
+}
+
+void elias_fano::save( sux_writer &writer ) {
+	writer.header( "elias_fano" );
+	writer.scalar( num_bits );
+	writer.scalar( num_ones );
+	writer.scalar( l );
+	writer.array( lower_bits, ( num_ones * l + 63  ) / 64 + 2 * ( l == 0 ) );
+	writer.array( upper_bits, ( ( num_ones + ( num_bits >> l ) + 1 ) + 63 ) / 64 );
+	select_upper->save( writer );
+	selectz_upper->save( writer );
+}
+
+MULTIVERSION uint64_t elias_fano::rank( const uint64_t k ) {
 	if ( num_ones == 0 ) return 0;
 	if ( k >= num_bits ) return num_ones;
 #ifdef DEBUG
@@ -119,7 +197,7 @@ uint64_t elias_fano::rank( const uint64_t k ) {
 	const uint64_t k_shiftr_l = k >> l;
 
 #ifndef PARSEARCH
-	int64_t pos = selectz_upper->select_zero( k_shiftr_l );
+	int64_t pos = zero_position( k_shiftr_l );
 	uint64_t rank = pos - ( k_shiftr_l );
 
 #ifdef DEBUG
@@ -143,9 +221,12 @@ uint64_t elias_fano::rank( const uint64_t k ) {
 	printf( "k: %llx lower %d : %llx\n", k, l, k_lower_bits );
 #endif
 
+	// Without lower bits there is nothing to compare: the values smaller than k are the ones before the last zero of bucket k - 1.
+	if ( l == 0 ) return k == 0 ? 0 : zero_position( k - 1 ) - ( k - 1 );
+
 	const uint64_t k_lower_bits_step_l = k_lower_bits * ones_step_l;
 
-	uint64_t pos = selectz_upper->select_zero( k_shiftr_l );
+	uint64_t pos = zero_position( k_shiftr_l );
 	uint64_t rank = pos - ( k_shiftr_l );
 	uint64_t rank_times_l = rank * l;
 
@@ -196,7 +277,7 @@ uint64_t elias_fano::rank( const uint64_t k ) {
 #endif
 }
 
-uint64_t elias_fano::select( const uint64_t rank ) {
+MULTIVERSION uint64_t elias_fano::select( const uint64_t rank ) {
 #ifdef DEBUG
 	printf( "Selecting %lld...\n", rank );
 #endif
@@ -206,7 +287,7 @@ uint64_t elias_fano::select( const uint64_t rank ) {
 	return ( select_upper->select( rank ) - rank ) << l | get_bits( lower_bits, rank * l, l );
 }
 
-uint64_t elias_fano::select( const uint64_t rank, uint64_t * const next ) {
+MULTIVERSION uint64_t elias_fano::select( const uint64_t rank, uint64_t * const next ) {
 	uint64_t s, t;
 	s = select_upper->select( rank, &t ) - rank;
 	t -= rank + 1;
@@ -216,6 +297,84 @@ uint64_t elias_fano::select( const uint64_t rank, uint64_t * const next ) {
 	return s << l | get_bits( lower_bits, position, l );
 }
 
+MULTIVERSION uint64_t elias_fano::next_geq( const uint64_t x, uint64_t * const index ) {
+	const uint64_t r = rank( x );
+	*index = r;
+	if ( r == num_ones ) return num_bits;
+
+	// If the value of index r is in the bucket of x, it is at position r + ( x >> l ) of the upper bits;
+	// otherwise that position is the zero closing the bucket of x, and the value is in the first nonempty bucket following it.
+	const uint64_t pos = next_one( r + ( x >> l ) );
+	return ( pos - r ) << l | get_bits( lower_bits, r * l, l );
+}
+
+MULTIVERSION uint64_t elias_fano::prev_leq( const uint64_t x, uint64_t * const index ) {
+	uint64_t r, h;
+	if ( num_ones == 0 ) r = h = 0;
+	else if ( x >= num_bits - 1 ) {
+		r = num_ones;
+		h = ( num_bits - 1 ) >> l;
+	}
+	else {
+		r = rank( x + 1 );
+		h = ( x + 1 ) >> l;
+	}
+
+	*index = r - 1;
+	if ( r == 0 ) return -1ULL;
+
+	// Symmetrically, the value of index r - 1 is at position r - 1 + h if it is in bucket h, and otherwise
+	// it is the last one before the zero at that position.
+	const uint64_t pos = prev_one( r - 1 + h );
+	return ( pos - ( r - 1 ) ) << l | get_bits( lower_bits, ( r - 1 ) * l, l );
+}
+
+elias_fano::cursor::cursor( elias_fano &ef ) : ef( &ef ), upper_bits( ef.upper_bits ), lower_bits( ef.lower_bits ), num_ones( ef.num_ones ), l( ef.l ) {
+	if ( ef.num_ones == 0 ) end();
+	else set( 0, ef.next_one( 0 ) );
+}
+
+MULTIVERSION uint64_t elias_fano::cursor::move_to( const uint64_t rank ) {
+	if ( rank >= ef->num_ones ) {
+		end();
+		return current_value;
+	}
+
+	if ( rank > current_index && rank - current_index <= MAX_CURSOR_SCAN ) {
+		// Short forward move: we skip ones of the upper bits a word at a time.
+		uint64_t skip = rank - current_index - 1, count;
+		while( skip >= ( count = __builtin_popcountll( window ) ) ) {
+			skip -= count;
+			window = ef->upper_bits[ ++word ];
+		}
+		return set( rank, word * 64 + select_in_word( window, skip ) );
+	}
+
+	return set( rank, ef->select_upper->select( rank ) );
+}
+
+MULTIVERSION uint64_t elias_fano::cursor::skip_to( const uint64_t x ) {
+	if ( current_value >= x ) return current_value;
+	if ( x >= ef->num_bits ) {
+		end();
+		return current_value;
+	}
+
+	// If x is a few buckets away, scanning is faster than jumping with rank().
+	if ( ( x >> ef->l ) - ( current_value >> ef->l ) <= MAX_CURSOR_SCAN_BUCKETS ) {
+		while( next() < x );
+		return current_value;
+	}
+
+	const uint64_t r = ef->rank( x );
+	if ( r == ef->num_ones ) {
+		end();
+		return current_value;
+	}
+
+	return set( r, ef->next_one( r + ( x >> ef->l ) ) );
+}
+
 uint64_t elias_fano::bit_count() {
 	return num_ones * l + num_ones + ( num_bits >> l ) + select_upper->bit_count() + selectz_upper->bit_count();
 }
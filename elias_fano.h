@@ -23,6 +23,8 @@
 #include <stdint.h>
 #include "simple_select_half.h"
 #include "simple_select_zero_half.h"
+#include "serialize.h"
+#include "allocator.h"
 
 class elias_fano {
 private:
@@ -39,6 +41,13 @@ private:
 	uint64_t ones_step_l;
 	uint64_t msbs_step_l;
 	uint64_t compressor;
+	bool mapped;
+	sux_allocator *allocator;
+	// A single arena holds the lower bits, the upper bits and the inventories of select_upper and selectz_upper.
+	void *arena;
+	uint64_t arena_bytes;
+	// Lays out the arena; the selection structures keep a pointer to it.
+	arena_allocator nested;
 
 	__inline static void set( uint64_t * const bits, const uint64_t pos ) {
 		bits[ pos / 64 ] |= 1ULL << pos % 64;
@@ -70,15 +79,106 @@ private:
 			}
 		}
 
+	// Returns the position in the upper bits of the zero closing bucket h (possibly the last bucket, which select_zero() does not cover).
+	__inline uint64_t zero_position( const uint64_t h ) {
+		return h < ( num_bits >> l ) ? selectz_upper->select_zero( h ) : num_ones + h;
+	}
+
+	// Returns the position of the first one of the upper bits at or after pos (there must be one).
+	__inline uint64_t next_one( const uint64_t pos ) {
+		uint64_t word = pos / 64;
+		uint64_t bits = upper_bits[ word ] & -1ULL << pos % 64;
+		while( bits == 0 ) bits = upper_bits[ ++word ];
+		return word * 64 + __builtin_ctzll( bits );
+	}
+
+	// Returns the position of the last one of the upper bits at or before pos (there must be one).
+	__inline uint64_t prev_one( const uint64_t pos ) {
+		uint64_t word = pos / 64;
+		uint64_t bits = upper_bits[ word ] & -1ULL >> 63 - pos % 64;
+		while( bits == 0 ) bits = upper_bits[ --word ];
+		return word * 64 + 63 - __builtin_clzll( bits );
+	}
+
+	void init( const uint64_t num_ones, const uint64_t num_bits, sux_allocator &allocator );
+	void build();
+	void init_broadword();
+
 public:
-	elias_fano( const uint64_t * const bits, const uint64_t num_bits );
+	elias_fano( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+	/** Builds an Elias-Fano representation of a nondecreasing sequence of values smaller than universe.
+	 * Time and space are proportional to num_values (plus num_values * log( universe / num_values ) bits). */
+	elias_fano( const uint64_t * const values, const uint64_t num_values, const uint64_t universe, sux_allocator &allocator = default_allocator() );
 	~elias_fano();
+	elias_fano( sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t rank( const uint64_t pos );
 	uint64_t select( const uint64_t rank );
+	/** Returns the number of values. */
+	uint64_t size() { return num_ones; }
 	uint64_t select( const uint64_t rank, uint64_t * const next );
+	/** Returns the first value greater than or equal to x and stores its index in *index;
+	 * if there is no such value, returns the universe size and stores the number of values. */
+	uint64_t next_geq( const uint64_t x, uint64_t * const index );
+	/** Returns the last value smaller than or equal to x and stores its index in *index;
+	 * if there is no such value, returns -1 and stores -1. */
+	uint64_t prev_leq( const uint64_t x, uint64_t * const index );
 	// Just for analysis purposes
 	void print_counts();
 	uint64_t bit_count();
+
+	/** A forward cursor over the values. It keeps the current word of the upper bits, so that
+	 * next() and short skips do not go through the selection structures. */
+	class cursor {
+	private:
+		elias_fano *ef;
+		// Copies of the fields of ef used by next()
+		const uint64_t *upper_bits, *lower_bits;
+		uint64_t num_ones;
+		int l;
+		uint64_t current_index, current_value;
+		// Position in the lower bits of the current value
+		uint64_t lower_pos;
+		// Index of the current word of the upper bits, and its ones following the current value
+		uint64_t word, window;
+
+		__inline void end() {
+			current_index = num_ones;
+			current_value = ef->num_bits;
+		}
+
+		// Positions the cursor at the value of index r, whose one is at position pos of the upper bits.
+		__inline uint64_t set( const uint64_t r, const uint64_t pos ) {
+			current_index = r;
+			lower_pos = r * l;
+			word = pos / 64;
+			window = upper_bits[ word ] & -2ULL << pos % 64;
+			return current_value = ( pos - r ) << l | get_bits( lower_bits, lower_pos, l );
+		}
+
+	public:
+		/** Creates a cursor on the first value. */
+		cursor( elias_fano &ef );
+		/** Moves to the next value and returns it; returns the universe size past the last value. */
+		__inline uint64_t next() {
+			if ( ++current_index >= num_ones ) {
+				end();
+				return current_value;
+			}
+
+			while( window == 0 ) window = upper_bits[ ++word ];
+			const uint64_t pos = word * 64 + __builtin_ctzll( window );
+			window &= window - 1;
+			lower_pos += l;
+			return current_value = ( pos - current_index ) << l | get_bits( lower_bits, lower_pos, l );
+		}
+		/** Moves to the first value greater than or equal to x that is not before the current one, and returns it. */
+		uint64_t skip_to( const uint64_t x );
+		/** Moves to the value of given index (the end, if it is the number of values) and returns it. */
+		uint64_t move_to( const uint64_t rank );
+		uint64_t index() { return current_index; }
+		uint64_t value() { return current_value; }
+	};
 };
 
 #endif
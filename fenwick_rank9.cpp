@@ -0,0 +1,162 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <algorithm>
+#include "fenwick_rank9.h"
+
+using namespace std;
+
+#define LOG2_BLOCKS_PER_SUPERBLOCK (6)
+#define BLOCKS_PER_SUPERBLOCK (1 << LOG2_BLOCKS_PER_SUPERBLOCK)
+#define LOG2_SUPERBLOCKS_PER_GROUP (6)
+#define SUPERBLOCKS_PER_GROUP (1 << LOG2_SUPERBLOCKS_PER_GROUP)
+
+// The relative counts that include word 0 of a block, that is, all seven of them.
+#define RELATIVE_ONES (0x0040201008040201ULL)
+
+fenwick_rank9::fenwick_rank9( uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	this->allocator = &allocator;
+	this->bits = bits;
+	num_words = ( num_bits + 63 ) / 64;
+	// There is always a block past the last bit, so that rank( num_bits ) needs no special case.
+	num_blocks = num_bits / 512 + 1;
+	num_superblocks = ( ( num_blocks - 1 ) >> LOG2_BLOCKS_PER_SUPERBLOCK ) + 1;
+	num_groups = ( ( num_superblocks - 1 ) >> LOG2_SUPERBLOCKS_PER_GROUP ) + 1;
+	num_levels = 64 - __builtin_clzll( num_groups );
+
+	arena_bytes = cache_align( num_blocks * 2 * sizeof *counts ) + cache_align( num_superblocks * sizeof *superblocks );
+	for( int h = 0; h < num_levels; h++ ) arena_bytes += cache_align( level_size( num_groups, h ) * sizeof **level );
+	arena = allocator.allocate( arena_bytes );
+	arena_allocator layout( arena, arena_bytes, true );
+	counts = (uint64_t *)layout.allocate( num_blocks * 2 * sizeof *counts );
+	superblocks = (uint32_t *)layout.allocate( num_superblocks * sizeof *superblocks );
+	for( int h = 0; h < num_levels; h++ ) level[ h ] = (uint64_t *)layout.allocate( level_size( num_groups, h ) * sizeof **level );
+
+	// Ones before the current block in its superblock, and before its superblock in its group
+	uint64_t d = 0, e = 0;
+	num_ones = 0;
+	for( uint64_t b = 0; b < num_blocks; b++ ) {
+		if ( ( b & BLOCKS_PER_SUPERBLOCK - 1 ) == 0 ) {
+			const uint64_t s = b >> LOG2_BLOCKS_PER_SUPERBLOCK;
+			e += d;
+			d = 0;
+			if ( ( s & SUPERBLOCKS_PER_GROUP - 1 ) == 0 ) {
+				if ( s != 0 ) node( s >> LOG2_SUPERBLOCKS_PER_GROUP ) = e;
+				num_ones += e;
+				e = 0;
+			}
+			superblocks[ s ] = e;
+		}
+
+		counts[ b * 2 ] = d;
+		uint64_t c = 0;
+		// Counts for words past the end are filled too, as set() updates all counts following a word.
+		for( int j = 0; j < 8; j++ ) {
+			if ( b * 8 + j < num_words ) c += __builtin_popcountll( bits[ b * 8 + j ] );
+			if ( j < 7 ) counts[ b * 2 + 1 ] |= c << 9 * j;
+		}
+		d += c;
+	}
+	node( num_groups ) = e + d;
+	num_ones += e + d;
+
+	// Every node adds itself to its parent, in increasing order, so that parents are complete when visited.
+	for( uint64_t i = 1; i <= num_groups; i++ ) {
+		const uint64_t parent = i + ( i & -i );
+		if ( parent <= num_groups ) node( parent ) += node( i );
+	}
+
+	printf("Number of ones: %lld Number of blocks: %lld\n", num_ones, num_blocks );
+
+#ifndef NDEBUG
+	uint64_t r = 0;
+	for( uint64_t i = 0; i < num_bits; i++ ) {
+		assert( rank( i ) == r );
+		r += get( i );
+	}
+	assert( rank( num_bits ) == r );
+	assert( r == num_ones );
+#endif
+}
+
+fenwick_rank9::~fenwick_rank9() {
+	allocator->deallocate( arena, arena_bytes );
+}
+
+// Returns the Fenwick node of the given (1-based) index.
+__inline uint64_t &fenwick_rank9::node( const uint64_t node ) {
+	const int h = __builtin_ctzll( node );
+	return level[ h ][ node >> h + 1 ];
+}
+
+// Returns the number of ones in the given number of initial groups.
+__inline uint64_t fenwick_rank9::prefix( uint64_t group ) {
+	uint64_t s = 0;
+	for( ; group != 0; group &= group - 1 ) s += node( group );
+	return s;
+}
+
+MULTIVERSION uint64_t fenwick_rank9::rank( const uint64_t k ) {
+	const uint64_t word = k / 64;
+	const uint64_t block = word / 4 & ~1;
+	const int offset = word % 8 - 1;
+	const uint64_t superblock = word >> 3 + LOG2_BLOCKS_PER_SUPERBLOCK;
+	return prefix( superblock >> LOG2_SUPERBLOCKS_PER_GROUP ) + superblocks[ superblock ] + counts[ block ] + ( counts[ block + 1 ] >> ( offset + ( offset >> sizeof offset * 8 - 4 & 0x8 ) ) * 9 & 0x1FF ) + __builtin_popcountll( bits[ word ] & ( ( 1ULL << k % 64 ) - 1 ) );
+}
+
+bool fenwick_rank9::get( const uint64_t k ) {
+	return bits[ k / 64 ] >> k % 64 & 1;
+}
+
+bool fenwick_rank9::set( const uint64_t k, const bool value ) {
+	const uint64_t word = k / 64;
+	const bool old = bits[ word ] >> k % 64 & 1;
+	if ( old == value ) return old;
+
+	const int64_t delta = value ? 1 : -1;
+	bits[ word ] ^= 1ULL << k % 64;
+	num_ones += delta;
+
+	const uint64_t block = word / 8;
+	// The relative counts from word % 8 on include the bit; the shift might move a count into bit 63, which must stay zero.
+	counts[ block * 2 + 1 ] += delta * ( RELATIVE_ONES << 9 * ( word % 8 ) & ~( 1ULL << 63 ) );
+	// Then the following blocks of the superblock, the following superblocks of the group, and the following groups.
+	const uint64_t block_end = min( ( block | BLOCKS_PER_SUPERBLOCK - 1 ) + 1, num_blocks );
+	for( uint64_t b = block + 1; b < block_end; b++ ) counts[ b * 2 ] += delta;
+	const uint64_t superblock = block >> LOG2_BLOCKS_PER_SUPERBLOCK;
+	const uint64_t superblock_end = min( ( superblock | SUPERBLOCKS_PER_GROUP - 1 ) + 1, num_superblocks );
+	for( uint64_t s = superblock + 1; s < superblock_end; s++ ) superblocks[ s ] += delta;
+	for( uint64_t i = ( superblock >> LOG2_SUPERBLOCKS_PER_GROUP ) + 1; i <= num_groups; i += i & -i ) node( i ) += delta;
+	return old;
+}
+
+bool fenwick_rank9::clear( const uint64_t k ) {
+	return set( k, false );
+}
+
+uint64_t fenwick_rank9::count() {
+	return num_ones;
+}
+
+uint64_t fenwick_rank9::bit_count() {
+	return arena_bytes * 8;
+}
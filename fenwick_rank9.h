@@ -0,0 +1,71 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef fenwick_rank9_h
+#define fenwick_rank9_h
+#include <stdint.h>
+#include "macros.h"
+#include "allocator.h"
+
+/** A rank structure on a bit vector that can be modified in place.
+ *
+ * Counts are stored in pairs of words as in rank9, but the first word of each pair contains the
+ * number of ones before the block relative to its superblock of 64 blocks (32768 bits). A second
+ * array contains the number of ones before each superblock relative to its group of 64 superblocks
+ * (about 2 million bits), and the number of ones before each group is given by a Fenwick tree,
+ * which is small enough to stay in cache. The tree is stored by levels (all nodes covering 2^h
+ * groups are contiguous). Setting or clearing a bit updates at most 63 block counts, 63 superblock
+ * counts and O(log n) Fenwick nodes.
+ *
+ * The bit vector is not copied: set() and clear() modify it. */
+
+class fenwick_rank9 {
+private:
+	uint64_t *bits, *counts;
+	uint32_t *superblocks;
+	uint64_t *level[ 64 ];
+	uint64_t num_words, num_blocks, num_superblocks, num_groups, num_ones;
+	int num_levels;
+	sux_allocator *allocator;
+	void *arena;
+	uint64_t arena_bytes;
+
+	__inline static uint64_t level_size( const uint64_t n, const int h ) {
+		return ( ( n >> h ) + 1 ) >> 1;
+	}
+	uint64_t &node( const uint64_t node );
+	uint64_t prefix( uint64_t group );
+
+public:
+	fenwick_rank9( uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+	~fenwick_rank9();
+	uint64_t rank( const uint64_t pos );
+	bool get( const uint64_t pos );
+	/** Sets the bit at pos to value, returning its previous value. */
+	bool set( const uint64_t pos, const bool value = true );
+	/** Clears the bit at pos, returning its previous value. */
+	bool clear( const uint64_t pos );
+	/** Returns the number of ones. */
+	uint64_t count();
+	// Just for analysis purposes
+	uint64_t bit_count();
+};
+
+#endif
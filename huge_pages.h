@@ -0,0 +1,87 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef huge_pages_h
+#define huge_pages_h
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/mman.h>
+
+/** Huge-page mappings for the arrays of rank/select structures.
+ *
+ * Random rank/select queries on large structures miss the TLB on almost every access.
+ * huge_pages_alloc() tries first 1 GiB pages (for arrays of at least 1 GiB) and 2 MiB pages
+ * from the hugetlbfs pool (MAP_HUGETLB), then, if no pages are reserved, a 2 MiB-aligned mapping
+ * with MADV_HUGEPAGE, which transparent huge pages will back when possible. heap_allocator
+ * (see allocator.h) uses it for large arrays when compiled with -DHUGEPAGES.
+ *
+ * Memory is zeroed. The length of a mapping is stored in the 64 bytes preceding the returned
+ * pointer, which is thus 64-byte aligned. */
+
+#define HUGE_PAGE_SIZE ( 1ULL << 21 )
+#define GIGANTIC_PAGE_SIZE ( 1ULL << 30 )
+#define HUGE_PAGE_PREFIX ( 64 )
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB ( 30 << MAP_HUGE_SHIFT )
+#endif
+
+__inline static void *huge_map( const uint64_t length, const int flags ) {
+	void * const p = mmap( NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0 );
+	return p == MAP_FAILED ? NULL : p;
+}
+
+__inline static void *huge_pages_alloc( const uint64_t bytes ) {
+	uint64_t length = ( bytes + HUGE_PAGE_PREFIX + GIGANTIC_PAGE_SIZE - 1 ) & -GIGANTIC_PAGE_SIZE;
+	char *base = bytes >= GIGANTIC_PAGE_SIZE ? (char *)huge_map( length, MAP_HUGETLB | MAP_HUGE_1GB ) : NULL;
+
+	if ( base == NULL ) {
+		length = ( bytes + HUGE_PAGE_PREFIX + HUGE_PAGE_SIZE - 1 ) & -HUGE_PAGE_SIZE;
+		base = (char *)huge_map( length, MAP_HUGETLB );
+	}
+
+	if ( base == NULL ) {
+		// No reserved huge pages: we map an extra huge page and trim the mapping to a 2 MiB boundary.
+		char * const p = (char *)huge_map( length + HUGE_PAGE_SIZE, 0 );
+		if ( p == NULL ) {
+			perror( "mmap" );
+			abort();
+		}
+		base = (char *)( ( (uint64_t)p + HUGE_PAGE_SIZE - 1 ) & -HUGE_PAGE_SIZE );
+		if ( base != p ) munmap( p, base - p );
+		munmap( base + length, p + HUGE_PAGE_SIZE - base );
+#ifdef MADV_HUGEPAGE
+		madvise( base, length, MADV_HUGEPAGE );
+#endif
+	}
+
+	*(uint64_t *)base = length;
+	return base + HUGE_PAGE_PREFIX;
+}
+
+__inline static void huge_pages_free( void * const p ) {
+	char * const base = (char *)p - HUGE_PAGE_PREFIX;
+	munmap( base, *(uint64_t *)base );
+}
+#endif
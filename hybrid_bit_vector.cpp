@@ -0,0 +1,309 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <algorithm>
+#include "hybrid_bit_vector.h"
+#include "select.h"
+
+using namespace std;
+
+#define LOG2_CHUNK_BITS (16)
+#define CHUNK_BITS ( 1 << LOG2_CHUNK_BITS )
+#define CHUNK_MASK ( CHUNK_BITS - 1 )
+#define LOG2_ONES_PER_SAMPLE (16)
+// The second directory word contains the type (2 bits), the length (17 bits) and the position of the data.
+#define LENGTH_SHIFT (2)
+#define LENGTH_MASK ( ( 1 << 17 ) - 1 )
+#define POSITION_SHIFT (19)
+
+// Returns word i of the bit vector, cleared past the last bit.
+__inline static uint64_t read_word( const uint64_t * const bits, const uint64_t num_bits, const uint64_t i ) {
+	return i * 64 + 64 <= num_bits ? bits[ i ] : bits[ i ] & ( 1ULL << num_bits % 64 ) - 1;
+}
+
+// Number of 16-bit counts of a raw chunk of given length
+__inline static int raw_blocks( const int length ) {
+	return ( length + 511 ) / 512;
+}
+
+hybrid_bit_vector::hybrid_bit_vector() {}
+
+hybrid_bit_vector::hybrid_bit_vector( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
+	this->num_bits = num_bits;
+	num_chunks = ( num_bits + CHUNK_MASK ) >> LOG2_CHUNK_BITS;
+
+	// A first pass computes the number of ones and the size of the data.
+	num_ones = num_data_words = 0;
+	for( uint64_t c = 0; c < num_chunks; c++ ) {
+		const int length = min( (uint64_t)CHUNK_BITS, num_bits - ( c << LOG2_CHUNK_BITS ) );
+		int ones = 0, runs = 0;
+		uint64_t carry = 0;
+		for( uint64_t i = c << LOG2_CHUNK_BITS - 6; i < ( c << LOG2_CHUNK_BITS - 6 ) + ( length + 63 ) / 64; i++ ) {
+			const uint64_t word = read_word( bits, num_bits, i );
+			ones += __builtin_popcountll( word );
+			// The first one of each run
+			runs += __builtin_popcountll( word & ~( word << 1 | carry ) );
+			carry = word >> 63;
+		}
+		num_ones += ones;
+		uint64_t words;
+		chunk_type( length, ones, runs, words );
+		num_data_words += words;
+	}
+
+	// The last sample is a sentinel.
+	num_samples = ( ( num_ones + ( 1 << LOG2_ONES_PER_SAMPLE ) - 1 ) >> LOG2_ONES_PER_SAMPLE ) + 1;
+
+	// There is a directory entry past the last chunk, so that rank( num_bits ) needs no special case.
+	arena_bytes = cache_align( ( num_chunks + 1 ) * 2 * sizeof *directory ) + cache_align( num_samples * sizeof *samples ) + cache_align( num_data_words * sizeof *data );
+	arena = allocator.allocate( arena_bytes );
+	arena_allocator layout( arena, arena_bytes, true );
+	directory = (uint64_t *)layout.allocate( ( num_chunks + 1 ) * 2 * sizeof *directory );
+	samples = (uint64_t *)layout.allocate( num_samples * sizeof *samples );
+	data = (uint64_t *)layout.allocate( num_data_words * sizeof *data );
+
+	uint64_t r = 0, position = 0;
+	counts[ RAW ] = counts[ SPARSE ] = counts[ RUN ] = 0;
+	for( uint64_t c = 0; c < num_chunks; c++ ) {
+		const int length = min( (uint64_t)CHUNK_BITS, num_bits - ( c << LOG2_CHUNK_BITS ) );
+		const uint64_t first_word = c << LOG2_CHUNK_BITS - 6, num_words = ( length + 63 ) / 64;
+		int ones = 0, runs = 0;
+		uint64_t carry = 0;
+		for( uint64_t i = first_word; i < first_word + num_words; i++ ) {
+			const uint64_t word = read_word( bits, num_bits, i );
+			ones += __builtin_popcountll( word );
+			runs += __builtin_popcountll( word & ~( word << 1 | carry ) );
+			carry = word >> 63;
+		}
+
+		uint64_t words;
+		const int type = chunk_type( length, ones, runs, words );
+		counts[ type ]++;
+		directory[ c * 2 ] = r;
+		directory[ c * 2 + 1 ] = type | (uint64_t)( type == RAW ? length : type == SPARSE ? ones : runs ) << LENGTH_SHIFT | position << POSITION_SHIFT;
+
+		uint64_t * const p = data + position;
+		switch( type ) {
+			case RAW: {
+				uint16_t * const block_counts = (uint16_t *)p;
+				uint64_t * const b = p + ( raw_blocks( length ) + 3 ) / 4;
+				int o = 0;
+				for( uint64_t i = 0; i < num_words; i++ ) {
+					if ( i % 8 == 0 ) block_counts[ i / 8 ] = o;
+					b[ i ] = read_word( bits, num_bits, first_word + i );
+					o += __builtin_popcountll( b[ i ] );
+				}
+				break;
+			}
+			case SPARSE: {
+				uint16_t * const pos = (uint16_t *)p;
+				int j = 0;
+				for( uint64_t i = 0; i < num_words; i++ )
+					for( uint64_t word = read_word( bits, num_bits, first_word + i ); word != 0; word &= word - 1 ) pos[ j++ ] = i * 64 + __builtin_ctzll( word );
+				assert( j == ones );
+				break;
+			}
+			default: {
+				uint16_t * const start = (uint16_t *)p, * const last = start + runs, * const before = last + runs;
+				int s = 0, e = 0;
+				uint64_t carry = 0;
+				for( uint64_t i = 0; i < num_words; i++ ) {
+					const uint64_t word = read_word( bits, num_bits, first_word + i );
+					const uint64_t next = i + 1 < num_words ? read_word( bits, num_bits, first_word + i + 1 ) & 1 : 0;
+					for( uint64_t starts = word & ~( word << 1 | carry ); starts != 0; starts &= starts - 1 ) start[ s++ ] = i * 64 + __builtin_ctzll( starts );
+					for( uint64_t ends = word & ~( word >> 1 | next << 63 ); ends != 0; ends &= ends - 1 ) last[ e++ ] = i * 64 + __builtin_ctzll( ends );
+					carry = word >> 63;
+				}
+				assert( s == runs && e == runs );
+				for( int j = 0, o = 0; j < runs; j++ ) {
+					before[ j ] = o;
+					o += last[ j ] - start[ j ] + 1;
+				}
+			}
+		}
+
+		r += ones;
+		position += words;
+	}
+
+	assert( r == num_ones );
+	assert( position == num_data_words );
+	directory[ num_chunks * 2 ] = num_ones;
+	directory[ num_chunks * 2 + 1 ] = position << POSITION_SHIFT;
+
+	// Sample i is the last chunk starting with at most i * 65536 ones before it.
+	uint64_t i = 0;
+	for( uint64_t c = 0; c < num_chunks; c++ )
+		while( i << LOG2_ONES_PER_SAMPLE < chunk_ones( c + 1 ) ) samples[ i++ ] = c;
+	assert( i == num_samples - 1 );
+	samples[ i ] = num_chunks == 0 ? 0 : num_chunks - 1;
+
+	printf( "Number of ones: %lld Chunks: %lld raw: %lld sparse: %lld runs: %lld\n", num_ones, num_chunks, counts[ RAW ], counts[ SPARSE ], counts[ RUN ] );
+
+#ifndef NDEBUG
+	r = 0;
+	for( uint64_t i = 0; i < num_bits; i++ ) {
+		assert( rank( i ) == r );
+		if ( bits[ i / 64 ] & 1ULL << i % 64 ) {
+			assert( select( r ) == i );
+			r++;
+		}
+	}
+	assert( rank( num_bits ) == r );
+#endif
+}
+
+hybrid_bit_vector::~hybrid_bit_vector() {
+	if ( ! mapped ) allocator->deallocate( arena, arena_bytes );
+}
+
+hybrid_bit_vector::hybrid_bit_vector( sux_reader &reader ) {
+	mapped = true;
+	reader.header( "hybrid_bit_vector" );
+	num_bits = reader.scalar();
+	num_chunks = reader.scalar();
+	num_samples = reader.scalar();
+	num_ones = reader.scalar();
+	num_data_words = reader.scalar();
+	for( int t = 0; t < 3; t++ ) counts[ t ] = reader.scalar();
+	directory = reader.array<uint64_t>( ( num_chunks + 1 ) * 2 );
+	samples = reader.array<uint64_t>( num_samples );
+	data = reader.array<uint64_t>( num_data_words );
+}
+
+void hybrid_bit_vector::save( sux_writer &writer ) {
+	writer.header( "hybrid_bit_vector" );
+	writer.scalar( num_bits );
+	writer.scalar( num_chunks );
+	writer.scalar( num_samples );
+	writer.scalar( num_ones );
+	writer.scalar( num_data_words );
+	for( int t = 0; t < 3; t++ ) writer.scalar( counts[ t ] );
+	writer.array( directory, ( num_chunks + 1 ) * 2 );
+	writer.array( samples, num_samples );
+	writer.array( data, num_data_words );
+}
+
+// Returns the number of ones of a chunk before pos, which must be smaller than the length of the chunk.
+__inline uint64_t hybrid_bit_vector::rank_in_chunk( const uint64_t chunk, const int pos ) {
+	const uint64_t d = directory[ chunk * 2 + 1 ];
+	const int length = d >> LENGTH_SHIFT & LENGTH_MASK;
+	const uint64_t * const p = data + ( d >> POSITION_SHIFT );
+
+	switch( d & 3 ) {
+		case RAW: {
+			const uint16_t * const block_counts = (const uint16_t *)p;
+			const uint64_t * const b = p + ( raw_blocks( length ) + 3 ) / 4;
+			uint64_t r = block_counts[ pos / 512 ];
+			for( int i = pos / 512 * 8; i < pos / 64; i++ ) r += __builtin_popcountll( b[ i ] );
+			return r + __builtin_popcountll( b[ pos / 64 ] & ( 1ULL << pos % 64 ) - 1 );
+		}
+		case SPARSE: {
+			const uint16_t * const positions = (const uint16_t *)p;
+			return lower_bound( positions, positions + length, pos ) - positions;
+		}
+		default: {
+			const uint16_t * const start = (const uint16_t *)p, * const last = start + length, * const before = last + length;
+			// The last run starting at or before pos
+			const int j = upper_bound( start, start + length, pos ) - start - 1;
+			if ( j < 0 ) return 0;
+			return before[ j ] + min( pos, last[ j ] + 1 ) - start[ j ];
+		}
+	}
+}
+
+// Returns the position in a chunk of the one of given rank among the ones of the chunk.
+__inline int hybrid_bit_vector::select_in_chunk( const uint64_t chunk, uint64_t rank ) {
+	const uint64_t d = directory[ chunk * 2 + 1 ];
+	const int length = d >> LENGTH_SHIFT & LENGTH_MASK;
+	const uint64_t * const p = data + ( d >> POSITION_SHIFT );
+
+	switch( d & 3 ) {
+		case RAW: {
+			const uint16_t * const block_counts = (const uint16_t *)p;
+			const uint64_t * const b = p + ( raw_blocks( length ) + 3 ) / 4;
+			const int block = upper_bound( block_counts, block_counts + raw_blocks( length ), rank ) - block_counts - 1;
+			rank -= block_counts[ block ];
+			int i = block * 8;
+			for( int c; rank >= ( c = __builtin_popcountll( b[ i ] ) ); i++ ) rank -= c;
+			return i * 64 + select_in_word( b[ i ], rank );
+		}
+		case SPARSE: return ( (const uint16_t *)p )[ rank ];
+		default: {
+			const uint16_t * const start = (const uint16_t *)p, * const before = start + length * 2;
+			// The last run with at most rank ones before it
+			const int j = upper_bound( before, before + length, rank ) - before - 1;
+			return start[ j ] + rank - before[ j ];
+		}
+	}
+}
+
+MULTIVERSION uint64_t hybrid_bit_vector::rank( const uint64_t pos ) {
+	// rank_in_chunk() needs a position inside the chunk, and the last chunk might be partial.
+	if ( pos == num_bits ) return num_ones;
+	const uint64_t chunk = pos >> LOG2_CHUNK_BITS;
+	const int p = pos & CHUNK_MASK;
+	if ( p == 0 ) return chunk_ones( chunk );
+	return chunk_ones( chunk ) + rank_in_chunk( chunk, p );
+}
+
+MULTIVERSION uint64_t hybrid_bit_vector::select( const uint64_t rank ) {
+	assert( rank < num_ones );
+	const uint64_t s = rank >> LOG2_ONES_PER_SAMPLE;
+	// The last chunk starting with at most rank ones before it, between two samples
+	uint64_t left = samples[ s ], right = samples[ s + 1 ] + 1;
+	while( right - left > 1 ) {
+		const uint64_t middle = ( left + right ) / 2;
+		if ( chunk_ones( middle ) <= rank ) left = middle;
+		else right = middle;
+	}
+
+	return ( left << LOG2_CHUNK_BITS ) + select_in_chunk( left, rank - chunk_ones( left ) );
+}
+
+uint64_t hybrid_bit_vector::bit_count() {
+	return ( ( num_chunks + 1 ) * 2 + num_samples + num_data_words ) * 64;
+}
+
+int hybrid_bit_vector::chunk_type( const int length, const int ones, const int runs, uint64_t &words ) {
+	const uint64_t raw = ( raw_blocks( length ) + 3 ) / 4 + ( length + 63 ) / 64, sparse = ( ones + 3 ) / 4, run = ( runs * 3 + 3 ) / 4;
+	// Ties go to the fastest representation.
+	if ( raw <= sparse && raw <= run ) {
+		words = raw;
+		return RAW;
+	}
+	if ( sparse <= run ) {
+		words = sparse;
+		return SPARSE;
+	}
+	words = run;
+	return RUN;
+}
+
+uint64_t hybrid_bit_vector::bit_count( const uint64_t num_bits, const uint64_t num_ones, const uint64_t num_data_words ) {
+	const uint64_t num_chunks = ( num_bits + CHUNK_MASK ) >> LOG2_CHUNK_BITS;
+	return ( ( num_chunks + 1 ) * 2 + ( ( num_ones + ( 1 << LOG2_ONES_PER_SAMPLE ) - 1 ) >> LOG2_ONES_PER_SAMPLE ) + 1 + num_data_words ) * 64;
+}
+
+void hybrid_bit_vector::print_counts() {}
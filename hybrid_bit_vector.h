@@ -0,0 +1,78 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef hybrid_bit_vector_h
+#define hybrid_bit_vector_h
+#include <stdint.h>
+#include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
+
+/** A compressed bit vector with rank and select that picks an encoding for each chunk of 2^16 bits.
+ *
+ * A chunk is stored, whichever is smallest, as raw bits with a 16-bit count every 512 bits, as the
+ * sorted 16-bit positions of its ones, or as its runs of ones (16-bit first and last position and
+ * number of ones before the run). Empty and full chunks are thus stored as zero and one runs. A
+ * directory with two words per chunk contains the number of ones before the chunk and the type,
+ * length and position of its data, so a chunk is found in constant time; a sample of the chunk of
+ * every 65536th one restricts the search for select to a few directory entries.
+ *
+ * The bit vector is not needed after construction. */
+
+class hybrid_bit_vector {
+public:
+	/** The types of a chunk. */
+	enum { RAW, SPARSE, RUN };
+
+private:
+	uint64_t *directory, *samples, *data;
+	uint64_t num_bits, num_chunks, num_samples, num_ones, num_data_words;
+	bool mapped;
+	sux_allocator *allocator;
+	void *arena;
+	uint64_t arena_bytes;
+	// Number of chunks of each type, for print_counts()
+	uint64_t counts[ 3 ];
+
+	__inline uint64_t chunk_ones( const uint64_t chunk ) {
+		return directory[ chunk * 2 ];
+	}
+
+	__inline uint64_t rank_in_chunk( const uint64_t chunk, const int pos );
+	__inline int select_in_chunk( const uint64_t chunk, const uint64_t rank );
+
+public:
+	hybrid_bit_vector();
+	hybrid_bit_vector( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+	~hybrid_bit_vector();
+	hybrid_bit_vector( sux_reader &reader );
+	void save( sux_writer &writer );
+	uint64_t rank( const uint64_t pos );
+	uint64_t select( const uint64_t rank );
+	// Just for analysis purposes
+	void print_counts();
+	uint64_t bit_count();
+	/** Returns the type of a chunk of given length, number of ones and number of runs of ones, and stores in words the number of words of its data. */
+	static int chunk_type( const int length, const int ones, const int runs, uint64_t &words );
+	/** Returns the number of bits used by an instance with given parameters, where num_data_words is the sum of the words of the chunks. */
+	static uint64_t bit_count( const uint64_t num_bits, const uint64_t num_ones, const uint64_t num_data_words );
+};
+
+#endif
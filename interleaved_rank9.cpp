@@ -0,0 +1,125 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include "interleaved_rank9.h"
+#include "popcount.h"
+
+#define BITS_PER_LINE (448)
+#define WORDS_PER_LINE (8)
+#define LOG2_LINES_PER_SUPERBLOCK (22)
+// Bits of the header holding the three 9-bit counts.
+#define SUBCOUNT_BITS (27)
+
+interleaved_rank9::interleaved_rank9() {}
+
+interleaved_rank9::interleaved_rank9( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
+	this->num_bits = num_bits;
+	const uint64_t num_words = ( num_bits + 63 ) / 64;
+	// There is always a line past the last bit, so that rank( num_bits ) needs no special case.
+	num_lines = num_bits / BITS_PER_LINE + 1;
+	num_superblocks = ( ( num_lines - 1 ) >> LOG2_LINES_PER_SUPERBLOCK ) + 1;
+
+	arena_bytes = num_lines * WORDS_PER_LINE * sizeof *lines + cache_align( num_superblocks * sizeof *superblocks );
+	arena = allocator.allocate( arena_bytes );
+	arena_allocator layout( arena, arena_bytes, true );
+	lines = (uint64_t *)layout.allocate( num_lines * WORDS_PER_LINE * sizeof *lines );
+	superblocks = (uint64_t *)layout.allocate( num_superblocks * sizeof *superblocks );
+
+	uint64_t c = 0;
+	for( uint64_t l = 0; l < num_lines; l++ ) {
+		uint64_t * const line = &lines[ l * WORDS_PER_LINE ];
+		if ( ( l & ( 1ULL << LOG2_LINES_PER_SUPERBLOCK ) - 1 ) == 0 ) superblocks[ l >> LOG2_LINES_PER_SUPERBLOCK ] = c;
+
+		line[ 0 ] = c - superblocks[ l >> LOG2_LINES_PER_SUPERBLOCK ] << SUBCOUNT_BITS;
+		uint64_t d = 0;
+		for( int j = 0; j < WORDS_PER_LINE - 1; j++ ) {
+			const uint64_t word = l * ( WORDS_PER_LINE - 1 ) + j;
+			if ( j != 0 && j % 2 == 0 ) line[ 0 ] |= d << 9 * ( j / 2 - 1 );
+			if ( word < num_words ) {
+				line[ j + 1 ] = bits[ word ];
+				d += __builtin_popcountll( bits[ word ] );
+			}
+		}
+		c += d;
+	}
+
+	num_ones = c;
+	assert( c <= num_bits );
+
+#ifndef NDEBUG
+	uint64_t r = 0;
+	for( uint64_t i = 0; i < num_bits; i++ ) {
+		assert( rank( i ) == r );
+		assert( get( i ) == ( bits[ i / 64 ] >> i % 64 & 1 ) );
+		r += bits[ i / 64 ] >> i % 64 & 1;
+	}
+	assert( rank( num_bits ) == r );
+#endif
+}
+
+interleaved_rank9::~interleaved_rank9() {
+	if ( ! mapped ) allocator->deallocate( arena, arena_bytes );
+}
+
+interleaved_rank9::interleaved_rank9( sux_reader &reader ) {
+	mapped = true;
+	reader.header( "interleaved_rank9" );
+	num_bits = reader.scalar();
+	num_lines = reader.scalar();
+	num_superblocks = reader.scalar();
+	num_ones = reader.scalar();
+	lines = reader.array<uint64_t>( num_lines * WORDS_PER_LINE );
+	superblocks = reader.array<uint64_t>( num_superblocks );
+}
+
+void interleaved_rank9::save( sux_writer &writer ) {
+	writer.header( "interleaved_rank9" );
+	writer.scalar( num_bits );
+	writer.scalar( num_lines );
+	writer.scalar( num_superblocks );
+	writer.scalar( num_ones );
+	writer.array( lines, num_lines * WORDS_PER_LINE );
+	writer.array( superblocks, num_superblocks );
+}
+
+MULTIVERSION uint64_t interleaved_rank9::rank( const uint64_t k ) {
+	const uint64_t l = k / BITS_PER_LINE;
+	const int word = k % BITS_PER_LINE / 64;
+	const uint64_t * const line = &lines[ l * WORDS_PER_LINE ];
+	const uint64_t header = line[ 0 ];
+	// For an odd word we add the preceding word (for word 0, the mask is zero and we read the header, which is in the same line).
+	return superblocks[ l >> LOG2_LINES_PER_SUPERBLOCK ] + ( header >> SUBCOUNT_BITS ) + ( header << 9 >> 9 * ( word / 2 ) & 0x1FF )
+		+ __builtin_popcountll( line[ word ] & -(uint64_t)( word & 1 ) ) + __builtin_popcountll( line[ word + 1 ] & ( ( 1ULL << k % 64 ) - 1 ) );
+}
+
+bool interleaved_rank9::get( const uint64_t k ) {
+	return lines[ k / BITS_PER_LINE * WORDS_PER_LINE + k % BITS_PER_LINE / 64 + 1 ] >> k % 64 & 1;
+}
+
+uint64_t interleaved_rank9::bit_count() {
+	return ( num_lines + num_superblocks ) * 64;
+}
+
+void interleaved_rank9::print_counts() {}
@@ -0,0 +1,60 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef interleaved_rank9_h
+#define interleaved_rank9_h
+#include <stdint.h>
+#include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
+
+/** A rank structure that owns a copy of the bit vector, interleaved with its counts so that a
+ * rank query touches a single cache line.
+ *
+ * Each 64-byte line contains a header word followed by seven words (448 bits) of the bit vector.
+ * The header contains the number of ones before the line, relative to a superblock of 2^22 lines
+ * (upper 37 bits), and the number of ones in the first 2, 4 and 6 words of the line (three
+ * 9-bit fields in the lower 27 bits). The absolute counts of the superblocks are so few that they
+ * stay in cache. The space occupied beyond the bit vector is 1/7 of its size (rank9: 1/4). */
+
+class interleaved_rank9 {
+private:
+	uint64_t *lines, *superblocks;
+	uint64_t num_bits, num_lines, num_superblocks, num_ones;
+	bool mapped;
+	sux_allocator *allocator;
+	void *arena;
+	uint64_t arena_bytes;
+
+public:
+	interleaved_rank9();
+	interleaved_rank9( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+	~interleaved_rank9();
+	interleaved_rank9( sux_reader &reader );
+	void save( sux_writer &writer );
+	uint64_t rank( const uint64_t pos );
+	/** Returns the bit at position pos. */
+	bool get( const uint64_t pos );
+	// Just for analysis purposes
+	void print_counts();
+	uint64_t bit_count();
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef inventory_builder_h
+#define inventory_builder_h
+#include <stdint.h>
+#include <vector>
+
+/** Calls f( pos ) for each one (each zero, if complement is true) of the bit vector in words
+ * [ first_word .. end_word ), ignoring bits past num_bits. Ones are found by trailing-zero
+ * counts, so the cost is proportional to the number of words plus the number of ones. */
+template<bool complement, typename F> static void for_each_one( const uint64_t * const bits, const uint64_t num_bits, const uint64_t first_word, const uint64_t end_word, F f ) {
+	for( uint64_t i = first_word; i < end_word; i++ ) {
+		uint64_t word = complement ? ~bits[ i ] : bits[ i ];
+		if ( ( i + 1 ) * 64 > num_bits ) word &= ( 1ULL << num_bits % 64 ) - 1;
+
+		while( word != 0 ) {
+			f( i * 64 + __builtin_ctzll( word ) );
+			word &= word - 1;
+		}
+	}
+}
+
+/** Streams the ones (zeroes, if complement is true) of a bit vector in blocks of 2<sup>log2_ones_per_block</sup>,
+ * calling f( block, positions, count, end ) for each block with the positions of its count ones and the
+ * position end of the first one of the next block (num_bits for the last block).
+ *
+ * Since the span of a block is known when its positions are handed over, inventories, subinventories
+ * and spills can be filled in a single pass. */
+template<bool complement, typename F> static void for_each_block( const uint64_t * const bits, const uint64_t num_bits, const int log2_ones_per_block, F f ) {
+	const uint64_t ones_per_block = 1ULL << log2_ones_per_block;
+	std::vector<uint64_t> positions( ones_per_block );
+	uint64_t block = 0, count = 0;
+
+	for_each_one<complement>( bits, num_bits, 0, ( num_bits + 63 ) / 64, [&]( const uint64_t pos ) {
+		if ( count == ones_per_block ) {
+			f( block++, &positions[ 0 ], count, pos );
+			count = 0;
+		}
+		positions[ count++ ] = pos;
+	} );
+
+	if ( count != 0 ) f( block, &positions[ 0 ], count, num_bits );
+}
+
+#endif
@@ -27,6 +27,7 @@
 jacobson::jacobson() {}
 
 jacobson::jacobson( const uint64_t * const bits, const uint64_t num_bits ) {
+	mapped = false;
 	this->bits = bits;
 	num_words = ( num_bits + 63 ) / 64;
 	num_counts = ( ( num_bits + 64 * 8 - 1 ) / ( 64 * 8 ) ) * 2;
@@ -88,13 +89,55 @@ jacobson::jacobson( const uint64_t * const bits, const uint64_t num_bits ) {
 }
 
 jacobson::~jacobson() {
-	delete [] counts;
-	delete [] supercounts;
-	delete [] precomp;
+	if ( ! mapped ) {
+		delete [] counts;
+		delete [] supercounts;
+		delete [] precomp;
+	}
+}
+
+jacobson::jacobson( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "jacobson" );
+	num_words = reader.scalar();
+	num_counts = reader.scalar();
+	block_size = reader.scalar();
+	superblock_size = reader.scalar();
+	num_patterns = reader.scalar();
+	counter_bits_per_block = reader.scalar();
+	counter_bits_per_superblock = reader.scalar();
+	counter_bits_per_precomp = reader.scalar();
+	num_bits_for_blocks = reader.scalar();
+	num_bits_for_superblocks = reader.scalar();
+	num_bits_for_precomp = reader.scalar();
+	num_ones = reader.scalar();
+	counts = reader.array<uint64_t>( ( num_bits_for_blocks + 63 ) / 64 );
+	supercounts = reader.array<uint64_t>( ( num_bits_for_superblocks + 63 ) / 64 );
+	precomp = reader.array<uint64_t>( ( num_bits_for_precomp + 63 ) / 64 );
+}
+
+void jacobson::save( sux_writer &writer ) {
+	writer.header( "jacobson" );
+	writer.scalar( num_words );
+	writer.scalar( num_counts );
+	writer.scalar( block_size );
+	writer.scalar( superblock_size );
+	writer.scalar( num_patterns );
+	writer.scalar( counter_bits_per_block );
+	writer.scalar( counter_bits_per_superblock );
+	writer.scalar( counter_bits_per_precomp );
+	writer.scalar( num_bits_for_blocks );
+	writer.scalar( num_bits_for_superblocks );
+	writer.scalar( num_bits_for_precomp );
+	writer.scalar( num_ones );
+	writer.array( counts, ( num_bits_for_blocks + 63 ) / 64 );
+	writer.array( supercounts, ( num_bits_for_superblocks + 63 ) / 64 );
+	writer.array( precomp, ( num_bits_for_precomp + 63 ) / 64 );
 }
 
 
-uint64_t jacobson::rank( const uint64_t k ) {
+MULTIVERSION uint64_t jacobson::rank( const uint64_t k ) {
 	const uint64_t superblock = k / superblock_size;
 	const uint64_t block = k / block_size;
 	const uint64_t residual = k % block_size;
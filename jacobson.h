@@ -22,6 +22,7 @@
 #define jacobson_h
 #include <stdint.h>
 #include "macros.h"
+#include "serialize.h"
 
 class jacobson {
 private:
@@ -56,11 +57,14 @@ private:
 		const uint64_t result = bits[ start_word ] >> start_bit;
 		return ( total_offset <= 64 ? result : result | bits[ start_word + 1 ] << 64 - start_bit ) & ( 1ULL << width ) - 1;
 	}
+	bool mapped;
 
 public:
 	jacobson();
 	jacobson( const uint64_t * const bits, const uint64_t num_bits );
 	~jacobson();
+	jacobson( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t rank( const uint64_t pos );
 	// Just for analysis purposes
 	void print_counts();
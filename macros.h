@@ -21,6 +21,15 @@
 #ifndef ranksel_macros_h
 #define ranksel_macros_h
 
+// Hot kernels are compiled for baseline x86-64, x86-64-v2 (POPCNT) and x86-64-v3 (BMI1/BMI2, AVX2):
+// the dynamic loader picks the best variant for the running processor once, at startup. Builds that already
+// target BMI2 (e.g., -march=native) need no variants, and the x86-64-v2 variant could not inline BMI2 kernels.
+#if defined(__x86_64__) && defined(__GNUC__) && ! defined(__clang__) && defined(__linux__) && ! defined(NO_MULTIVERSION) && ! defined(__BMI2__)
+#define MULTIVERSION __attribute__(( target_clones( "default", "arch=x86-64-v2", "arch=x86-64-v3" ) ))
+#else
+#define MULTIVERSION
+#endif
+
 #define ONES_STEP_4 ( 0x1111111111111111ULL )
 #define ONES_STEP_8 ( 0x0101010101010101ULL )
 #define ONES_STEP_9 ( 1ULL << 0 | 1ULL << 9 | 1ULL << 18 | 1ULL << 27 | 1ULL << 36 | 1ULL << 45 | 1ULL << 54 )
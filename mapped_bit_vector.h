@@ -0,0 +1,86 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef mapped_bit_vector_h
+#define mapped_bit_vector_h
+#include <stdint.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** A read-only bit vector backed by a memory mapping of a file containing 64-bit words in native
+ * byte order, so that the kernel can page it in and out instead of keeping it resident.
+ *
+ * The mapping is followed by at least one page of zeroes, as structures may read the word following
+ * the last one. Use advise_sequential() during construction, which scans the vector a few times,
+ * and advise_random() before queries. */
+
+class mapped_bit_vector {
+private:
+	void *address;
+	uint64_t length, reserved;
+
+public:
+	/** Maps a file; the vector contains all the bits of the file. A trailing partial word is padded with zeroes. */
+	mapped_bit_vector( const char * const path ) : address( NULL ), length( 0 ), reserved( 0 ) {
+		const int fd = open( path, O_RDONLY );
+		struct stat st;
+		if ( fd == -1 || fstat( fd, &st ) == -1 ) {
+			perror( path );
+			if ( fd != -1 ) close( fd );
+			return;
+		}
+
+		length = st.st_size;
+		// We reserve an anonymous (hence zero-filled) region one page longer than the file and map the file over it.
+		const uint64_t page_size = sysconf( _SC_PAGESIZE );
+		reserved = ( length + page_size - 1 ) / page_size * page_size + page_size;
+		address = mmap( NULL, reserved, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		if ( address == MAP_FAILED || length != 0 && mmap( address, length, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED ) {
+			perror( path );
+			if ( address != MAP_FAILED ) munmap( address, reserved );
+			address = NULL;
+		}
+		close( fd );
+	}
+
+	~mapped_bit_vector() {
+		if ( address != NULL ) munmap( address, reserved );
+	}
+
+	/** Returns whether the file was mapped successfully. */
+	bool ok() { return address != NULL; }
+	const uint64_t *bits() { return (const uint64_t *)address; }
+	uint64_t num_bits() { return length * 8; }
+
+	/** Hints that the vector will be scanned sequentially (aggressive read-ahead, early reclaim). */
+	void advise_sequential() {
+		if ( length != 0 ) madvise( address, length, MADV_SEQUENTIAL );
+	}
+
+	/** Hints that the vector will be accessed at random positions (no read-ahead). */
+	void advise_random() {
+		if ( length != 0 ) madvise( address, length, MADV_RANDOM );
+	}
+};
+
+#endif
@@ -0,0 +1,48 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef parallel_h
+#define parallel_h
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Below this number of words per thread, spawning threads does not pay off.
+#define MIN_WORDS_PER_THREAD (1 << 16)
+
+/** Returns the number of threads to use for a construction pass over num_words words:
+ * num_threads if positive, all available cores otherwise, but never so many that a thread
+ * would get less than MIN_WORDS_PER_THREAD words. */
+__inline static int choose_threads( const uint64_t num_words, const int num_threads ) {
+	uint64_t t = num_threads > 0 ? num_threads : std::thread::hardware_concurrency();
+	if ( t == 0 ) t = 1;
+	if ( t > num_words / MIN_WORDS_PER_THREAD ) t = num_words / MIN_WORDS_PER_THREAD;
+	return t == 0 ? 1 : (int)t;
+}
+
+/** Runs f( 0 ), &hellip;, f( num_threads - 1 ) in parallel and waits for all of them. */
+template<typename F> static void run_threads( const int num_threads, F f ) {
+	std::vector<std::thread> threads;
+	for( int t = 1; t < num_threads; t++ ) threads.push_back( std::thread( f, t ) );
+	f( 0 );
+	for( size_t t = 0; t < threads.size(); t++ ) threads[ t ].join();
+}
+
+#endif
@@ -0,0 +1,248 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include "select.h"
+#include "partitioned_elias_fano.h"
+
+using namespace std;
+
+#define LOG2_CHUNK_SIZE (7)
+#define CHUNK_SIZE ( 1 << LOG2_CHUNK_SIZE )
+#define CHUNK_MASK ( CHUNK_SIZE - 1 )
+
+// Returns the type of a chunk of n values in [ 0 .. u ) and, for Elias-Fano chunks, the number of lower bits.
+int partitioned_elias_fano::chunk_type( const uint64_t u, const uint64_t n, int &l ) {
+	l = max( 0, msb( u / n ) );
+	if ( u == n ) return RUN;
+	return u <= n * l + n + ( u >> l ) + 1 ? BITMAP : EF;
+}
+
+uint64_t partitioned_elias_fano::chunk_bits( const uint64_t u, const uint64_t n ) {
+	int l;
+	switch( chunk_type( u, n, l ) ) {
+		case RUN: return 0;
+		case BITMAP: return u;
+		default: return n * l + n + ( u >> l ) + 1;
+	}
+}
+
+partitioned_elias_fano::partitioned_elias_fano( const uint64_t * const values, const uint64_t num_values, const uint64_t universe ) {
+	mapped = false;
+	this->num_values = num_values;
+	this->universe = universe;
+	num_chunks = ( num_values + CHUNK_MASK ) >> LOG2_CHUNK_SIZE;
+
+	vector<uint64_t> last( num_chunks ), offset( num_chunks );
+	uint64_t counts[ 3 ] = {};
+	num_bits = 0;
+
+	for( uint64_t c = 0; c < num_chunks; c++ ) {
+		const uint64_t first = c << LOG2_CHUNK_SIZE, n = min( (uint64_t)CHUNK_SIZE, num_values - first );
+		const uint64_t base = c == 0 ? 0 : last[ c - 1 ] + 1;
+		last[ c ] = values[ first + n - 1 ];
+		assert( last[ c ] < universe );
+		offset[ c ] = num_bits;
+		num_bits += chunk_bits( last[ c ] - base + 1, n );
+	}
+
+	// Two words of padding for get_word()
+	bits = new uint64_t[ ( num_bits + 63 ) / 64 + 2 ]();
+
+	for( uint64_t c = 0; c < num_chunks; c++ ) {
+		const uint64_t first = c << LOG2_CHUNK_SIZE, n = min( (uint64_t)CHUNK_SIZE, num_values - first );
+		const uint64_t base = c == 0 ? 0 : last[ c - 1 ] + 1, u = last[ c ] - base + 1;
+		int l;
+		const int type = chunk_type( u, n, l );
+		counts[ type ]++;
+
+		for( uint64_t i = 0; i < n; i++ ) {
+			assert( i == 0 || values[ first + i - 1 ] < values[ first + i ] );
+			const uint64_t v = values[ first + i ] - base;
+			if ( type == BITMAP ) bits[ ( offset[ c ] + v ) / 64 ] |= 1ULL << ( offset[ c ] + v ) % 64;
+			else if ( type == EF ) {
+				if ( l != 0 ) set_bits( bits, offset[ c ] + i * l, l, v & ( 1ULL << l ) - 1 );
+				const uint64_t pos = offset[ c ] + n * l + ( v >> l ) + i;
+				bits[ pos / 64 ] |= 1ULL << pos % 64;
+			}
+		}
+	}
+
+	printf( "Chunks: %lld run: %lld bitmap: %lld Elias-Fano: %lld\n", num_chunks, counts[ RUN ], counts[ BITMAP ], counts[ EF ] );
+	printf( "Chunk bits: %lld\n", num_bits );
+
+	endpoints = new elias_fano( last.data(), num_chunks, universe );
+	offsets = new elias_fano( offset.data(), num_chunks, num_bits + 1 );
+
+#ifndef NDEBUG
+	uint64_t index;
+	for( uint64_t i = 0; i < num_values; i++ ) {
+		assert( select( i ) == values[ i ] );
+		assert( rank( values[ i ] ) == i );
+		assert( next_geq( values[ i ], &index ) == values[ i ] && index == i );
+		if ( values[ i ] + 1 < universe ) {
+			assert( rank( values[ i ] + 1 ) == i + 1 );
+			assert( next_geq( values[ i ] + 1, &index ) == ( i + 1 < num_values ? values[ i + 1 ] : universe ) && index == i + 1 );
+		}
+		if ( values[ i ] != 0 && ( i == 0 || values[ i - 1 ] != values[ i ] - 1 ) ) {
+			assert( rank( values[ i ] - 1 ) == i );
+			assert( next_geq( values[ i ] - 1, &index ) == values[ i ] && index == i );
+		}
+	}
+#endif
+}
+
+partitioned_elias_fano::~partitioned_elias_fano() {
+	if ( ! mapped ) delete [] bits;
+	delete endpoints;
+	delete offsets;
+}
+
+partitioned_elias_fano::partitioned_elias_fano( sux_reader &reader ) {
+	mapped = true;
+	reader.header( "partitioned_elias_fano" );
+	num_values = reader.scalar();
+	universe = reader.scalar();
+	num_chunks = reader.scalar();
+	num_bits = reader.scalar();
+	bits = reader.array<uint64_t>( ( num_bits + 63 ) / 64 + 2 );
+	endpoints = new elias_fano( reader );
+	offsets = new elias_fano( reader );
+}
+
+void partitioned_elias_fano::save( sux_writer &writer ) {
+	writer.header( "partitioned_elias_fano" );
+	writer.scalar( num_values );
+	writer.scalar( universe );
+	writer.scalar( num_chunks );
+	writer.scalar( num_bits );
+	writer.array( bits, ( num_bits + 63 ) / 64 + 2 );
+	endpoints->save( writer );
+	offsets->save( writer );
+}
+
+// Returns the position, relative to start, of the one of given rank following start (there must be one).
+uint64_t partitioned_elias_fano::select_one( const uint64_t start, uint64_t rank ) {
+	for( uint64_t pos = start;; pos += 64 ) {
+		const uint64_t word = get_word( bits, pos );
+		const uint64_t count = __builtin_popcountll( word );
+		if ( rank < count ) return pos - start + select_in_word( word, rank );
+		rank -= count;
+	}
+}
+
+// Returns the position, relative to start, of the zero of given rank following start (there must be one).
+uint64_t partitioned_elias_fano::select_zero( const uint64_t start, uint64_t rank ) {
+	for( uint64_t pos = start;; pos += 64 ) {
+		const uint64_t word = ~get_word( bits, pos );
+		const uint64_t count = __builtin_popcountll( word );
+		if ( rank < count ) return pos - start + select_in_word( word, rank );
+		rank -= count;
+	}
+}
+
+// Retrieves base, universe, length and bit offset of chunk c.
+void partitioned_elias_fano::chunk( const uint64_t c, uint64_t &base, uint64_t &u, uint64_t &n, uint64_t &offset ) {
+	uint64_t last;
+	if ( c == 0 ) {
+		base = 0;
+		last = endpoints->select( 0 );
+	}
+	else base = endpoints->select( c - 1, &last ) + 1;
+
+	u = last - base + 1;
+	n = min( (uint64_t)CHUNK_SIZE, num_values - ( c << LOG2_CHUNK_SIZE ) );
+	offset = offsets->select( c );
+}
+
+// Returns the number of values of a chunk smaller than y, which must be smaller than u.
+uint64_t partitioned_elias_fano::rank_in_chunk( const uint64_t u, const uint64_t n, const uint64_t offset, const uint64_t y ) {
+	int l;
+	switch( chunk_type( u, n, l ) ) {
+		case RUN: return y;
+		case BITMAP: {
+			uint64_t r = 0, pos = offset;
+			for( ; pos + 64 <= offset + y; pos += 64 ) r += __builtin_popcountll( get_word( bits, pos ) );
+			if ( pos < offset + y ) r += __builtin_popcountll( get_word( bits, pos ) & ( 1ULL << offset + y - pos ) - 1 );
+			return r;
+		}
+		default: {
+			// We reach the first one of the bucket of y and scan forward.
+			const uint64_t upper = offset + n * l, h = y >> l;
+			uint64_t pos = h == 0 ? 0 : select_zero( upper, h - 1 ) + 1, r = pos - h;
+			const uint64_t y_lower = y & ( 1ULL << l ) - 1;
+			while( r < n && ( bits[ ( upper + pos ) / 64 ] & 1ULL << ( upper + pos ) % 64 ) && get_bits( bits, offset + r * l, l ) < y_lower ) {
+				r++;
+				pos++;
+			}
+			return r;
+		}
+	}
+}
+
+// Returns the value of given rank in a chunk, relative to its base.
+uint64_t partitioned_elias_fano::select_in_chunk( const uint64_t u, const uint64_t n, const uint64_t offset, const uint64_t rank ) {
+	int l;
+	switch( chunk_type( u, n, l ) ) {
+		case RUN: return rank;
+		case BITMAP: return select_one( offset, rank );
+		default: return ( select_one( offset + n * l, rank ) - rank ) << l | get_bits( bits, offset + rank * l, l );
+	}
+}
+
+MULTIVERSION uint64_t partitioned_elias_fano::rank( const uint64_t pos ) {
+	if ( pos >= universe ) return num_values;
+	const uint64_t c = endpoints->rank( pos );
+	if ( c == num_chunks ) return num_values;
+
+	uint64_t base, u, n, offset;
+	chunk( c, base, u, n, offset );
+	return ( c << LOG2_CHUNK_SIZE ) + ( pos < base ? 0 : rank_in_chunk( u, n, offset, pos - base ) );
+}
+
+MULTIVERSION uint64_t partitioned_elias_fano::select( const uint64_t rank ) {
+	uint64_t base, u, n, offset;
+	chunk( rank >> LOG2_CHUNK_SIZE, base, u, n, offset );
+	return base + select_in_chunk( u, n, offset, rank & CHUNK_MASK );
+}
+
+MULTIVERSION uint64_t partitioned_elias_fano::next_geq( const uint64_t x, uint64_t * const index ) {
+	const uint64_t c = x >= universe ? num_chunks : endpoints->rank( x );
+	if ( c == num_chunks ) {
+		*index = num_values;
+		return universe;
+	}
+
+	// The last value of chunk c is at least x, so the answer is in chunk c.
+	uint64_t base, u, n, offset;
+	chunk( c, base, u, n, offset );
+	const uint64_t r = x < base ? 0 : rank_in_chunk( u, n, offset, x - base );
+	*index = ( c << LOG2_CHUNK_SIZE ) + r;
+	return base + select_in_chunk( u, n, offset, r );
+}
+
+uint64_t partitioned_elias_fano::bit_count() {
+	return num_bits + endpoints->bit_count() + offsets->bit_count();
+}
+
+void partitioned_elias_fano::print_counts() {}
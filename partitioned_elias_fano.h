@@ -0,0 +1,102 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef partitioned_elias_fano_h
+#define partitioned_elias_fano_h
+#include <stdint.h>
+#include "macros.h"
+#include "elias_fano.h"
+#include "serialize.h"
+
+/** A partitioned Elias-Fano representation of a strictly increasing sequence.
+ *
+ * The sequence is split into chunks of 2<sup>LOG2_CHUNK_SIZE</sup> values, and each chunk is stored
+ * relatively to the value following the last value of the previous chunk as an implicit run, a bitmap or an
+ * Elias-Fano list, whichever is smallest. The type of a chunk is a function of its length and universe,
+ * so it is not stored. The last value and the bit offset of each chunk are stored in two elias_fano instances. */
+
+class partitioned_elias_fano {
+private:
+	enum { RUN, BITMAP, EF };
+
+	uint64_t *bits;
+	uint64_t num_values, universe, num_chunks, num_bits;
+	elias_fano *endpoints, *offsets;
+	bool mapped;
+
+	__inline static void set_bits( uint64_t * const bits, const uint64_t start, const int width, const uint64_t value ) { 
+			const uint64_t start_word = start / 64;
+			const uint64_t end_word = ( start + width - 1 ) / 64;
+			const uint64_t start_bit = start % 64;
+
+			if ( start_word == end_word ) {
+				bits[ start_word ] &= ~ ( ( ( 1ULL << width ) - 1 ) << start_bit );
+				bits[ start_word ] |= value << start_bit;
+			}
+			else {
+				// Here start_bit > 0.
+				bits[ start_word ] &= ( 1ULL << start_bit ) - 1;
+				bits[ start_word ] |= value << start_bit;
+				bits[ end_word ] &=  - ( 1ULL << width - 64 + start_bit );
+				bits[ end_word ] |= value >> 64 - start_bit;
+			}
+		}
+
+	__inline static uint64_t get_bits( const uint64_t * const bits, const uint64_t start, const int width ) {
+		const uint64_t start_word = start / 64;
+		const int start_bit = start % 64;
+		const int total_offset = start_bit + width;
+		const uint64_t result = bits[ start_word ] >> start_bit;
+		return ( total_offset <= 64 ? result : result | bits[ start_word + 1 ] << 64 - start_bit ) & ( 1ULL << width ) - 1;
+	}
+
+	// Returns the 64 bits starting at position start.
+	__inline static uint64_t get_word( const uint64_t * const bits, const uint64_t start ) {
+		const int start_bit = start % 64;
+		const uint64_t result = bits[ start / 64 ] >> start_bit;
+		return start_bit == 0 ? result : result | bits[ start / 64 + 1 ] << 64 - start_bit;
+	}
+
+	static int chunk_type( const uint64_t u, const uint64_t n, int &l );
+	static uint64_t chunk_bits( const uint64_t u, const uint64_t n );
+	uint64_t select_one( const uint64_t start, uint64_t rank );
+	uint64_t select_zero( const uint64_t start, uint64_t rank );
+	void chunk( const uint64_t c, uint64_t &base, uint64_t &u, uint64_t &n, uint64_t &offset );
+	uint64_t rank_in_chunk( const uint64_t u, const uint64_t n, const uint64_t offset, const uint64_t y );
+	uint64_t select_in_chunk( const uint64_t u, const uint64_t n, const uint64_t offset, const uint64_t rank );
+
+public:
+	partitioned_elias_fano( const uint64_t * const values, const uint64_t num_values, const uint64_t universe );
+	~partitioned_elias_fano();
+	partitioned_elias_fano( sux_reader &reader );
+	void save( sux_writer &writer );
+	uint64_t rank( const uint64_t pos );
+	uint64_t select( const uint64_t rank );
+	/** Returns the first value greater than or equal to x and stores its index in *index;
+	 * if there is no such value, returns the universe size and stores the number of values. */
+	uint64_t next_geq( const uint64_t x, uint64_t * const index );
+	/** Returns the number of values. */
+	uint64_t size() { return num_values; }
+	// Just for analysis purposes
+	void print_counts();
+	uint64_t bit_count();
+};
+
+#endif
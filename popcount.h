@@ -20,6 +20,8 @@
 
 #ifndef popcount_h
 #define popcount_h
+#include <stdint.h>
+#include "macros.h"
 
 const unsigned char popcount[] = {
 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,
@@ -32,4 +34,30 @@ const unsigned char popcount[] = {
 3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,4,5,5,6,5,6,6,7,5,6,6,7,6,7,7,8,
 };
 
+// Counts the ones in an array of words; used by constructors.
+
+MULTIVERSION static uint64_t count_ones_generic( const uint64_t * const bits, const uint64_t num_words ) {
+	uint64_t c = 0;
+	for( uint64_t i = 0; i < num_words; i++ ) c += __builtin_popcountll( bits[ i ] );
+	return c;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__) && ! defined(__clang__) && ! defined(NO_MULTIVERSION)
+// The loader cannot pick AVX-512 VPOPCNTDQ variants by itself, so we check CPUID once, at startup.
+__attribute__(( target( "popcnt,avx512f,avx512vpopcntdq" ) )) static uint64_t count_ones_vpopcntdq( const uint64_t * const bits, const uint64_t num_words ) {
+	uint64_t c = 0;
+	for( uint64_t i = 0; i < num_words; i++ ) c += __builtin_popcountll( bits[ i ] );
+	return c;
+}
+
+static const bool has_vpopcntdq = ( __builtin_cpu_init(), __builtin_cpu_supports( "avx512vpopcntdq" ) );
+#endif
+
+__inline static uint64_t count_ones( const uint64_t * const bits, const uint64_t num_words ) {
+#if defined(__x86_64__) && defined(__GNUC__) && ! defined(__clang__) && ! defined(NO_MULTIVERSION)
+	if ( has_vpopcntdq ) return count_ones_vpopcntdq( bits, num_words );
+#endif
+	return count_ones_generic( bits, num_words );
+}
+
 #endif
@@ -0,0 +1,185 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include "poppy.h"
+#include "popcount.h"
+
+#define LOG2_BLOCK_BITS (11)
+#define LOG2_BLOCKS_PER_SUPERBLOCK (21)
+#define LOG2_ONES_PER_SAMPLE (13)
+// Between two samples further apart than this number of basic blocks we use binary search.
+#define MAX_LINEAR_SCAN (8)
+
+poppy::poppy() {}
+
+poppy::poppy( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
+	this->bits = bits;
+	assert( num_bits < 1ULL << 43 );
+	num_words = ( num_bits + 63 ) / 64;
+	// There is always a basic block past the last bit, so that rank( num_bits ) needs no special case.
+	num_blocks = ( num_bits >> LOG2_BLOCK_BITS ) + 1;
+	num_superblocks = ( ( num_blocks - 1 ) >> LOG2_BLOCKS_PER_SUPERBLOCK ) + 1;
+
+	const uint64_t c = count_ones( bits, num_words );
+	num_ones = c;
+	assert( c <= num_bits );
+	// The last sample is a sentinel.
+	num_samples = ( ( c + ( 1 << LOG2_ONES_PER_SAMPLE ) - 1 ) >> LOG2_ONES_PER_SAMPLE ) + 1;
+
+	printf("Number of ones: %lld Number of basic blocks: %lld\n", c, num_blocks );
+
+	arena_bytes = cache_align( num_superblocks * sizeof *superblocks ) + cache_align( num_blocks * sizeof *blocks ) + cache_align( num_samples * sizeof *samples );
+	arena = allocator.allocate( arena_bytes );
+	arena_allocator layout( arena, arena_bytes, true );
+	superblocks = (uint64_t *)layout.allocate( num_superblocks * sizeof *superblocks );
+	blocks = (uint64_t *)layout.allocate( num_blocks * sizeof *blocks );
+	samples = (uint32_t *)layout.allocate( num_samples * sizeof *samples );
+
+	uint64_t d = 0;
+	for( uint64_t b = 0; b < num_blocks; b++ ) {
+		if ( ( b & ( 1ULL << LOG2_BLOCKS_PER_SUPERBLOCK ) - 1 ) == 0 ) superblocks[ b >> LOG2_BLOCKS_PER_SUPERBLOCK ] = d;
+		blocks[ b ] = d - superblocks[ b >> LOG2_BLOCKS_PER_SUPERBLOCK ];
+
+		const uint64_t start = d;
+		for( int s = 0; s < 4; s++ ) {
+			uint64_t ones = 0;
+			for( uint64_t w = b * 32 + s * 8; w < b * 32 + s * 8 + 8 && w < num_words; w++ ) ones += __builtin_popcountll( bits[ w ] );
+			if ( s < 3 ) blocks[ b ] |= ones << 32 + 10 * s;
+			d += ones;
+		}
+
+		// Every one whose rank is a multiple of the sample period and lies in this block is sampled here.
+		for( uint64_t r = ( start + ( 1 << LOG2_ONES_PER_SAMPLE ) - 1 ) >> LOG2_ONES_PER_SAMPLE << LOG2_ONES_PER_SAMPLE; r < d; r += 1 << LOG2_ONES_PER_SAMPLE )
+			samples[ r >> LOG2_ONES_PER_SAMPLE ] = b;
+	}
+
+	assert( d == c );
+	samples[ num_samples - 1 ] = num_blocks - 1;
+
+#ifndef NDEBUG
+	uint64_t r = 0;
+	for( uint64_t i = 0; i < num_bits; i++ ) {
+		assert( rank( i ) == r );
+		if ( bits[ i / 64 ] >> i % 64 & 1 ) {
+			assert( select( r ) == i );
+			r++;
+		}
+	}
+	assert( rank( num_bits ) == r );
+#endif
+}
+
+poppy::~poppy() {
+	if ( ! mapped ) allocator->deallocate( arena, arena_bytes );
+}
+
+poppy::poppy( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "poppy" );
+	num_words = reader.scalar();
+	num_blocks = reader.scalar();
+	num_superblocks = reader.scalar();
+	num_samples = reader.scalar();
+	num_ones = reader.scalar();
+	superblocks = reader.array<uint64_t>( num_superblocks );
+	blocks = reader.array<uint64_t>( num_blocks );
+	samples = reader.array<uint32_t>( num_samples );
+}
+
+void poppy::save( sux_writer &writer ) {
+	writer.header( "poppy" );
+	writer.scalar( num_words );
+	writer.scalar( num_blocks );
+	writer.scalar( num_superblocks );
+	writer.scalar( num_samples );
+	writer.scalar( num_ones );
+	writer.array( superblocks, num_superblocks );
+	writer.array( blocks, num_blocks );
+	writer.array( samples, num_samples );
+}
+
+MULTIVERSION uint64_t poppy::rank( const uint64_t k ) {
+	const uint64_t block = k >> LOG2_BLOCK_BITS;
+	const uint64_t entry = blocks[ block ];
+	const int sub = k >> 9 & 3;
+	// The sub-block counts before sub are the lowest 10 * sub bits above the relative count.
+	uint64_t r = superblocks[ block >> LOG2_BLOCKS_PER_SUPERBLOCK ] + (uint32_t)entry;
+	const uint64_t sub_counts = entry >> 32;
+	r += ( sub_counts & 0x3FF ) * ( sub > 0 ) + ( sub_counts >> 10 & 0x3FF ) * ( sub > 1 ) + ( sub_counts >> 20 & 0x3FF ) * ( sub > 2 );
+
+	const uint64_t word = k / 64, first = word & ~7ULL;
+	if ( first + 8 <= num_words ) {
+		// Branchless: we count all words of the sub-block, masking out those following word.
+		const int w = word & 7;
+		for( int j = 0; j < 8; j++ ) r += __builtin_popcountll( bits[ first + j ] & -(uint64_t)( j < w ) );
+	}
+	else for( uint64_t w = first; w < word; w++ ) r += __builtin_popcountll( bits[ w ] );
+
+	return r + __builtin_popcountll( bits[ word ] & ( ( 1ULL << k % 64 ) - 1 ) );
+}
+
+MULTIVERSION uint64_t poppy::select( const uint64_t rank ) {
+	assert( rank < num_ones );
+	// The basic block containing the one lies between two consecutive samples.
+	uint64_t lo = samples[ rank >> LOG2_ONES_PER_SAMPLE ], hi = samples[ ( rank >> LOG2_ONES_PER_SAMPLE ) + 1 ];
+
+	if ( hi - lo <= MAX_LINEAR_SCAN ) {
+		while( lo < hi && block_count( lo + 1 ) <= rank ) lo++;
+	}
+	else {
+		// Find the last block in [lo..hi] whose count is at most rank.
+		while( lo < hi ) {
+			const uint64_t mid = ( lo + hi + 1 ) / 2;
+			if ( block_count( mid ) <= rank ) lo = mid;
+			else hi = mid - 1;
+		}
+	}
+
+	uint64_t left = rank - block_count( lo );
+	const uint64_t sub_counts = blocks[ lo ] >> 32;
+	uint64_t word = lo * 32;
+
+	for( int s = 0; s < 3; s++ ) {
+		const uint64_t ones = sub_counts >> 10 * s & 0x3FF;
+		if ( left < ones ) break;
+		left -= ones;
+		word += 8;
+	}
+
+	for( ;; word++ ) {
+		const uint64_t ones = __builtin_popcountll( bits[ word ] );
+		if ( left < ones ) break;
+		left -= ones;
+	}
+
+	return word * 64 + select_in_word( bits[ word ], left );
+}
+
+uint64_t poppy::bit_count() {
+	return ( num_superblocks + num_blocks ) * 64 + num_samples * 32;
+}
+
+void poppy::print_counts() {}
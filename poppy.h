@@ -0,0 +1,68 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef poppy_h
+#define poppy_h
+#include <stdint.h>
+#include "macros.h"
+#include "select.h"
+#include "serialize.h"
+#include "allocator.h"
+
+/** A rank/select structure with about 3% space overhead, following Zhou, Andersen and
+ * Kaminsky's poppy.
+ *
+ * The bit vector is split into basic blocks of 2048 bits. For each basic block, a single word
+ * contains the number of ones before the block, relative to the enclosing superblock of 2^32 bits
+ * (lower 32 bits), and the number of ones in each of the first three 512-bit sub-blocks (three
+ * 10-bit fields); superblock counts are absolute. Selection starts from the basic block of every
+ * 8192nd one, and continues with a search on the basic blocks, the sub-blocks and the words.
+ *
+ * Basic block indices are stored in 32 bits, so the bit vector must be shorter than 2^43 bits. */
+
+class poppy {
+private:
+	const uint64_t *bits;
+	uint64_t *superblocks, *blocks;
+	uint32_t *samples;
+	uint64_t num_words, num_blocks, num_superblocks, num_samples, num_ones;
+	bool mapped;
+	sux_allocator *allocator;
+	void *arena;
+	uint64_t arena_bytes;
+
+	__inline uint64_t block_count( const uint64_t block ) {
+		return superblocks[ block >> 21 ] + (uint32_t)blocks[ block ];
+	}
+
+public:
+	poppy();
+	poppy( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+	~poppy();
+	poppy( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
+	uint64_t rank( const uint64_t pos );
+	uint64_t select( const uint64_t rank );
+	// Just for analysis purposes
+	void print_counts();
+	uint64_t bit_count();
+};
+
+#endif
@@ -0,0 +1,96 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "posting_lists.h"
+
+using namespace std;
+
+static bool shorter( elias_fano * const a, elias_fano * const b ) {
+	return a->size() < b->size();
+}
+
+MULTIVERSION uint64_t intersect_lists( elias_fano ** const lists, const int num_lists, uint64_t * const out ) {
+	if ( num_lists == 0 ) return 0;
+
+	vector<elias_fano *> sorted( lists, lists + num_lists );
+	sort( sorted.begin(), sorted.end(), shorter );
+
+	vector<elias_fano::cursor> cursor;
+	for( int i = 0; i < num_lists; i++ ) cursor.push_back( elias_fano::cursor( *sorted[ i ] ) );
+
+	const uint64_t size = sorted[ 0 ]->size();
+	uint64_t n = 0, candidate = cursor[ 0 ].value();
+
+	for( int i = 1; cursor[ 0 ].index() < size; ) {
+		if ( i == num_lists ) {
+			out[ n++ ] = candidate;
+			// Skipping to candidate + 1 rather than calling next() discards repeated values.
+			candidate = cursor[ 0 ].skip_to( candidate + 1 );
+			i = 1;
+			continue;
+		}
+
+		const uint64_t v = cursor[ i ].skip_to( candidate );
+		if ( cursor[ i ].index() == sorted[ i ]->size() ) break;
+
+		if ( v == candidate ) i++;
+		else {
+			candidate = cursor[ 0 ].skip_to( v );
+			i = 1;
+		}
+	}
+
+	return n;
+}
+
+MULTIVERSION uint64_t unite_lists( elias_fano ** const lists, const int num_lists, uint64_t * const out ) {
+	vector<elias_fano::cursor> cursor;
+	// A min-heap of pairs (current value, list)
+	vector<pair<uint64_t, int> > heap;
+
+	for( int i = 0; i < num_lists; i++ ) {
+		cursor.push_back( elias_fano::cursor( *lists[ i ] ) );
+		if ( lists[ i ]->size() != 0 ) heap.push_back( make_pair( cursor[ i ].value(), i ) );
+	}
+
+	make_heap( heap.begin(), heap.end(), greater<pair<uint64_t, int> >() );
+
+	uint64_t n = 0;
+	while( ! heap.empty() ) {
+		pop_heap( heap.begin(), heap.end(), greater<pair<uint64_t, int> >() );
+		const uint64_t v = heap.back().first;
+		const int i = heap.back().second;
+		heap.pop_back();
+
+		if ( n == 0 || out[ n - 1 ] != v ) out[ n++ ] = v;
+
+		const uint64_t next = cursor[ i ].next();
+		if ( cursor[ i ].index() < lists[ i ]->size() ) {
+			heap.push_back( make_pair( next, i ) );
+			push_heap( heap.begin(), heap.end(), greater<pair<uint64_t, int> >() );
+		}
+	}
+
+	return n;
+}
@@ -0,0 +1,37 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef posting_lists_h
+#define posting_lists_h
+#include <stdint.h>
+#include "elias_fano.h"
+
+/** Writes into out the values common to all num_lists lists, in increasing order and without
+ * repetitions, and returns their number. The output must have room for the values of the shortest list.
+ *
+ * Lists are scanned from the shortest, and the other lists are advanced with elias_fano::cursor::skip_to(),
+ * which gallops through rank() when the next candidate is far away. */
+uint64_t intersect_lists( elias_fano ** const lists, const int num_lists, uint64_t * const out );
+
+/** Writes into out the values appearing in at least one of num_lists lists, in increasing order and
+ * without repetitions, and returns their number. The output must have room for the values of all lists. */
+uint64_t unite_lists( elias_fano ** const lists, const int num_lists, uint64_t * const out );
+
+#endif
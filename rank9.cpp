@@ -20,46 +20,82 @@
 
 #include <cassert>
 #include <cstring>
+#include <vector>
 #include "rank9.h"
+#include "rank9_counts.h"
+
+using namespace std;
+
+// Number of positions we prefetch ahead in rank_batch().
+#define PREFETCH_DISTANCE (16)
 
 rank9::rank9() {}
 
-rank9::rank9( const uint64_t * const bits, const uint64_t num_bits ) {
+rank9::rank9( const uint64_t * const bits, const uint64_t num_bits ) : rank9( bits, num_bits, 0 ) {}
+
+rank9::rank9( const uint64_t * const bits, const uint64_t num_bits, const int num_threads, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
 	this->bits = bits;
 	num_words = ( num_bits + 63 ) / 64;
 	num_counts = ( ( num_bits + 64 * 8 - 1 ) / ( 64 * 8 ) ) * 2;
 	
 	// Init rank structure
-	counts = new uint64_t[ num_counts + 1 ]();
-
-	uint64_t c = 0;
-	uint64_t pos = 0;
-	for( uint64_t i = 0; i < num_words; i += 8, pos += 2 ) {
-		counts[ pos ] = c;
-		c += __builtin_popcountll( bits[ i ] );
-		for( int j = 1;  j < 8; j++ ) {
-			counts[ pos + 1 ] |= ( c - counts[ pos ] ) << 9 * ( j - 1 );
-			if ( i + j < num_words ) c += __builtin_popcountll( bits[ i + j ] );
-		}
-	}
+	counts = (uint64_t *)allocator.allocate( ( num_counts + 1 ) * sizeof *counts );
 
-	counts[ num_counts ] = c;
+	vector<uint64_t> first_word, ones_before;
+	const uint64_t c = build_rank9_counts( bits, num_words, counts, choose_threads( num_words, num_threads ), first_word, ones_before );
 
+	assert( counts[ num_counts ] == c );
 	assert( c <= num_bits );
 }
 
 rank9::~rank9() {
-	delete [] counts;
+	if ( ! mapped ) allocator->deallocate( counts, ( num_counts + 1 ) * sizeof *counts );
 }
 
+rank9::rank9( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "rank9" );
+	num_words = reader.scalar();
+	num_counts = reader.scalar();
+	counts = reader.array<uint64_t>( num_counts + 1 );
+}
+
+void rank9::save( sux_writer &writer ) {
+	writer.header( "rank9" );
+	writer.scalar( num_words );
+	writer.scalar( num_counts );
+	writer.array( counts, num_counts + 1 );
+}
 
-uint64_t rank9::rank( const uint64_t k ) {
+
+MULTIVERSION uint64_t rank9::rank( const uint64_t k ) {
 	const uint64_t word = k / 64;
 	const uint64_t block = word / 4 & ~1;
 	const int offset = word % 8 - 1;
 	return counts[ block ] + ( counts[ block + 1 ] >> ( offset + ( offset >> sizeof offset * 8 - 4 & 0x8 ) ) * 9 & 0x1FF ) + __builtin_popcountll( bits[ word ] & ( ( 1ULL << k % 64 ) - 1 ) );
 }
 
+MULTIVERSION void rank9::rank_batch( const uint64_t * const pos, const size_t n, uint64_t * const out ) {
+	const size_t prefetched = n < PREFETCH_DISTANCE ? n : PREFETCH_DISTANCE;
+
+	for( size_t i = 0; i < prefetched; i++ ) {
+		__builtin_prefetch( &counts[ pos[ i ] / 256 & ~1 ] );
+		__builtin_prefetch( &bits[ pos[ i ] / 64 ] );
+	}
+
+	for( size_t i = 0; i < n; i++ ) {
+		if ( i + PREFETCH_DISTANCE < n ) {
+			const uint64_t p = pos[ i + PREFETCH_DISTANCE ];
+			__builtin_prefetch( &counts[ p / 256 & ~1 ] );
+			__builtin_prefetch( &bits[ p / 64 ] );
+		}
+		out[ i ] = rank( pos[ i ] );
+	}
+}
+
 uint64_t rank9::bit_count() {
 	return num_counts * 64;
 }
@@ -21,19 +21,32 @@
 #ifndef rank9_h
 #define rank9_h
 #include <stdint.h>
+#include <cstddef>
 #include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
 
 class rank9 {
 private:
 	const uint64_t *bits;
 	uint64_t *counts, *inventory;
 	uint64_t num_words, num_counts, inventory_size, ones_per_inventory, log2_ones_per_inventory, num_ones;
+	bool mapped;
+	sux_allocator *allocator;
 
 public:
 	rank9();
 	rank9( const uint64_t * const bits, const uint64_t num_bits );
+	/** Builds the structure using num_threads threads (all cores if nonpositive); the result does not depend on num_threads.
+	 * The counts are allocated by allocator. */
+	rank9( const uint64_t * const bits, const uint64_t num_bits, const int num_threads, sux_allocator &allocator = default_allocator() );
 	~rank9();
+	rank9( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t rank( const uint64_t pos );
+	/** Ranks n positions at once, writing the results into out; count pairs and
+	 * bit words are prefetched a few positions ahead to overlap cache misses. */
+	void rank_batch( const uint64_t * const pos, const size_t n, uint64_t * const out );
 	// Just for analysis purposes
 	void print_counts();
 	uint64_t bit_count();
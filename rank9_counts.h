@@ -0,0 +1,81 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef rank9_counts_h
+#define rank9_counts_h
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include "macros.h"
+#include "popcount.h"
+#include "parallel.h"
+
+// Fills the rank9 counts of blocks [ first_block, end_block ), given the number c of ones before first_block.
+MULTIVERSION static void fill_rank9_counts( const uint64_t * const bits, const uint64_t num_words, uint64_t * const counts, const uint64_t first_block, const uint64_t end_block, uint64_t c ) {
+	uint64_t pos = first_block * 2;
+	for( uint64_t i = first_block * 8; i < end_block * 8 && i < num_words; i += 8, pos += 2 ) {
+		counts[ pos ] = c;
+		c += __builtin_popcountll( bits[ i ] );
+		for( int j = 1;  j < 8; j++ ) {
+			counts[ pos + 1 ] |= ( c - counts[ pos ] ) << 9 * ( j - 1 );
+			if ( i + j < num_words ) c += __builtin_popcountll( bits[ i + j ] );
+		}
+	}
+}
+
+/** Splits the words of a bit vector into num_threads chunks made of whole blocks of eight words
+ * and returns the number of ones. On return, first_word and ones_before (num_threads + 1 entries)
+ * contain the chunk boundaries and the number of ones preceding each chunk, so that construction
+ * passes can be split in the same way, and the result does not depend on the number of threads. */
+static uint64_t split_rank9_chunks( const uint64_t * const bits, const uint64_t num_words, const int num_threads, std::vector<uint64_t> &first_word, std::vector<uint64_t> &ones_before ) {
+	const uint64_t num_blocks = ( num_words + 7 ) / 8;
+	first_word.resize( num_threads + 1 );
+	ones_before.resize( num_threads + 1 );
+
+	for( int t = 0; t <= num_threads; t++ ) first_word[ t ] = std::min( ( num_blocks * t / num_threads ) * 8, num_words );
+
+	run_threads( num_threads, [&]( const int t ) {
+		ones_before[ t + 1 ] = count_ones( bits + first_word[ t ], first_word[ t + 1 ] - first_word[ t ] );
+	} );
+
+	ones_before[ 0 ] = 0;
+	for( int t = 0; t < num_threads; t++ ) ones_before[ t + 1 ] += ones_before[ t ];
+	return ones_before[ num_threads ];
+}
+
+/** Fills the rank9 counts of a bit vector (counts must be zeroed and have room for a final entry)
+ * using the chunks computed by split_rank9_chunks(), one per thread. */
+static void fill_rank9_chunks( const uint64_t * const bits, const uint64_t num_words, uint64_t * const counts, const int num_threads, const std::vector<uint64_t> &first_word, const std::vector<uint64_t> &ones_before ) {
+	run_threads( num_threads, [&]( const int t ) {
+		fill_rank9_counts( bits, num_words, counts, first_word[ t ] / 8, ( first_word[ t + 1 ] + 7 ) / 8, ones_before[ t ] );
+	} );
+
+	counts[ ( ( num_words + 7 ) / 8 ) * 2 ] = ones_before[ num_threads ];
+}
+
+/** Fills the rank9 counts of a bit vector (see fill_rank9_chunks()) and returns the number of ones;
+ * first_word and ones_before are set as in split_rank9_chunks(). */
+static uint64_t build_rank9_counts( const uint64_t * const bits, const uint64_t num_words, uint64_t * const counts, const int num_threads, std::vector<uint64_t> &first_word, std::vector<uint64_t> &ones_before ) {
+	const uint64_t c = split_rank9_chunks( bits, num_words, num_threads, first_word, ones_before );
+	fill_rank9_chunks( bits, num_words, counts, num_threads, first_word, ones_before );
+	return c;
+}
+
+#endif
@@ -24,14 +24,15 @@
 
 rank9b::rank9b() {}
 
-rank9b::rank9b( const uint64_t * const bits, const uint64_t num_bits ) {
+rank9b::rank9b( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
 	this->bits = bits;
 	num_words = ( num_bits + 63 ) / 64;
 	num_counts = ( ( num_bits + 64 * 8 - 1 ) / ( 64 * 8 ) ) * 2;
 	
 	// Init rank structure
-	counts = new uint64_t[ num_counts + 1 ];
-	memset( counts, 0, ( num_counts + 1 ) * sizeof *counts );
+	counts = (uint64_t *)allocator.allocate( ( num_counts + 1 ) * sizeof *counts );
 
 	uint64_t c = 0;
 	uint64_t pos = 0;
@@ -50,11 +51,27 @@ rank9b::rank9b( const uint64_t * const bits, const uint64_t num_bits ) {
 }
 
 rank9b::~rank9b() {
-	delete [] counts;
+	if ( ! mapped ) allocator->deallocate( counts, ( num_counts + 1 ) * sizeof *counts );
+}
+
+rank9b::rank9b( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "rank9b" );
+	num_words = reader.scalar();
+	num_counts = reader.scalar();
+	counts = reader.array<uint64_t>( num_counts + 1 );
+}
+
+void rank9b::save( sux_writer &writer ) {
+	writer.header( "rank9b" );
+	writer.scalar( num_words );
+	writer.scalar( num_counts );
+	writer.array( counts, num_counts + 1 );
 }
 
 
-uint64_t rank9b::rank( const uint64_t k ) {
+MULTIVERSION uint64_t rank9b::rank( const uint64_t k ) {
 	const uint64_t word = k / 64;
 	const uint64_t block = word / 4 & ~1;
 	const int offset = word % 8;
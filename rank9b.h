@@ -22,17 +22,23 @@
 #define rank9b_h
 #include <stdint.h>
 #include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
 
 class rank9b {
 private:
 	const uint64_t *bits;
 	uint64_t *counts, *inventory;
 	uint64_t num_words, num_counts, inventory_size, ones_per_inventory, log2_ones_per_inventory, num_ones;
+	bool mapped;
+	sux_allocator *allocator;
 
 public:
 	rank9b();
-	rank9b( const uint64_t * const bits, const uint64_t num_bits );
+	rank9b( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
 	~rank9b();
+	rank9b( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t rank( const uint64_t pos );
 	// Just for analysis purposes
 	void print_counts();
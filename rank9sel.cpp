@@ -26,7 +26,12 @@
 #include <climits>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <vector>
 #include "rank9sel.h"
+#include "rank9_counts.h"
+#include "inventory_builder.h"
+
+using namespace std;
 
 #define ONES_PER_INVENTORY (512)
 #define LOG2_ONES_PER_INVENTORY (9)
@@ -36,26 +41,20 @@
 uint64_t single, one_level, two_levels, shorts, longs, longlongs;
 #endif
 
-rank9sel::rank9sel( const uint64_t * const bits, const uint64_t num_bits ) {
+rank9sel::rank9sel( const uint64_t * const bits, const uint64_t num_bits ) : rank9sel( bits, num_bits, 0 ) {}
+
+rank9sel::rank9sel( const uint64_t * const bits, const uint64_t num_bits, const int num_threads, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
 	this->bits = bits;
 	num_words = ( num_bits + 63 ) / 64;
 	num_counts = ( ( num_bits + 64 * 8 - 1 ) / ( 64 * 8 ) ) * 2;
 
-	// Init rank/select structure
-	counts = new uint64_t[ num_counts + 1 ]();
-
-	uint64_t c = 0;
-	uint64_t pos = 0;
-	for( uint64_t i = 0; i < num_words; i += 8, pos += 2 ) {
-		counts[ pos ] = c;
-		c += __builtin_popcountll( bits[ i ] );
-		for( int j = 1;  j < 8; j++ ) {
-			counts[ pos + 1 ] |= ( c - counts[ pos ] ) << 9 * ( j - 1 );
-			if ( i + j < num_words ) c += __builtin_popcountll( bits[ i + j ] );
-		}
-	}
+	// All passes are split among threads in the same way: thread t scans words [ first_word[ t ] .. first_word[ t + 1 ] ), which contain the ones of rank ones_before[ t ] onwards.
+	const int threads = choose_threads( num_words, num_threads );
+	vector<uint64_t> first_word, ones_before;
+	const uint64_t c = split_rank9_chunks( bits, num_words, threads, first_word, ones_before );
 
-	counts[ num_counts ] = c;
 	printf("Number of ones: %lld\n", c );	
 
 	assert( c <= num_bits );
@@ -65,114 +64,125 @@ rank9sel::rank9sel( const uint64_t * const bits, const uint64_t num_bits ) {
 	printf("Number of ones per inventory item: %d\n", ONES_PER_INVENTORY );	
 	assert( ONES_PER_INVENTORY <= 8 * 64 );
 
-	inventory = new uint64_t[ inventory_size + 1 ]();
-	subinventory = new uint64_t[ ( num_words + 3 ) / 4 ]();
-
-	uint64_t d = 0;
-	for( uint64_t i = 0; i < num_words; i++ )
-		for( int j = 0; j < 64; j++ )
-			if ( bits[ i ] & 1ULL << j ) {
-				if ( ( d & INVENTORY_MASK ) == 0 ) {
-					inventory[ d >> LOG2_ONES_PER_INVENTORY ] = i * 64 + j;
-					assert( counts[ ( i / 8 ) * 2 ] <= d ); 
-					assert( counts[ ( i / 8 ) * 2 + 2 ] > d ); 
-				}
-
-				d++;
+	// Init rank/select structure: counts, inventory and subinventory share a single arena
+	arena_bytes = cache_align( ( num_counts + 1 ) * sizeof *counts ) + cache_align( ( inventory_size + 1 ) * sizeof *inventory ) + cache_align( ( num_words + 3 ) / 4 * sizeof *subinventory );
+	arena = allocator.allocate( arena_bytes );
+	arena_allocator layout( arena, arena_bytes, true );
+	counts = (uint64_t *)layout.allocate( ( num_counts + 1 ) * sizeof *counts );
+	inventory = (uint64_t *)layout.allocate( ( inventory_size + 1 ) * sizeof *inventory );
+	subinventory = (uint64_t *)layout.allocate( ( num_words + 3 ) / 4 * sizeof *subinventory );
+
+	fill_rank9_chunks( bits, num_words, counts, threads, first_word, ones_before );
+
+	run_threads( threads, [&]( const int t ) {
+		uint64_t d = ones_before[ t ];
+		for_each_one<false>( bits, num_bits, first_word[ t ], first_word[ t + 1 ], [&]( const uint64_t p ) {
+			if ( ( d & INVENTORY_MASK ) == 0 ) {
+				inventory[ d >> LOG2_ONES_PER_INVENTORY ] = p;
+				assert( counts[ ( p / 512 ) * 2 ] <= d ); 
+				assert( counts[ ( p / 512 ) * 2 + 2 ] > d ); 
 			}
 
-	assert( c == d );
+			d++;
+		} );
+
+		assert( d == ones_before[ t + 1 ] );
+	} );
+
 	inventory[ inventory_size ] = ( ( num_words + 3 ) & ~3ULL ) * 64;
 
-	printf("Inventory entries filled: %lld\n", d / ONES_PER_INVENTORY + 1 );
+	printf("Inventory entries filled: %lld\n", inventory_size + 1 );
 
 #ifdef DEBUG
 	printf("First inventories: %lld %lld %lld %lld\n", inventory[ 0 ], inventory[ 1 ], inventory[ 2 ], inventory[ 3 ] );
 #endif
 
-	d = 0;
-	int state;
-	uint64_t *s, first_bit, index, span, block_span, block_left, counts_at_start;
-	
-	for( uint64_t i = 0; i < num_words; i++ )
-		for( int j = 0; j < 64; j++ )
-			if ( bits[ i ] & 1ULL << j ) {
-				if ( ( d & INVENTORY_MASK ) == 0 ) {
-					first_bit = i * 64 + j;
-					index = d >> LOG2_ONES_PER_INVENTORY;
-					assert( inventory[ index ] == first_bit );
-					s = &subinventory[ ( inventory[ index ] / 64 ) / 4 ];
-					span = ( inventory[ index + 1 ] / 64 ) / 4 - ( inventory[ index ] / 64 ) / 4;
-					state = -1;
-					counts_at_start = counts[ ( ( inventory[ index ] / 64 ) / 8 ) * 2 ];
-					block_span = ( inventory[ index + 1 ] / 64 ) / 8 - ( inventory[ index ] / 64 ) / 8;
-					block_left = ( inventory[ index ] / 64 ) / 8;
-
-					if ( span >= 512 ) state = 0;
-					else if ( span >= 256 ) state = 1;
-					else if ( span >= 128 ) state = 2;
-					else if ( span >= 16 ) {
-						assert( ( block_span + 8 & -8LL ) + 8 <= span * 4 );
-
-						int k;
-						for( k = 0; k < block_span; k++ ) {
-							assert( ((uint16_t *)s)[ k + 8 ] == 0 );
-							((uint16_t *)s)[ k + 8 ] = counts[ ( block_left + k + 1 ) * 2 ] - counts_at_start;
-						}
-
-						for( ; k < ( block_span + 8 & -8LL ); k++ ) {
-							assert( ((uint16_t *)s)[ k + 8 ] == 0 );
-							((uint16_t *)s)[ k + 8 ] = 0xFFFFU;
-						}
-
-						assert( block_span / 8 <= 8 );
-
-						for( k = 0; k < block_span / 8; k++ ) {
-							assert( ((uint16_t *)s)[ k ] == 0 );
-							((uint16_t *)s)[ k ] = counts[ ( block_left + ( k + 1 ) * 8 ) * 2 ] - counts_at_start;
-						}
-
-						for( ; k < 8; k++ ) {
-							assert( ((uint16_t *)s)[ k ] == 0 );
-							((uint16_t *)s)[ k ] = 0xFFFFU;
-						}
+	// Each inventory block gets a disjoint part of the subinventory. Counts-based subinventories are written by the thread
+	// that sees the first one of the block; exact positions are written by the thread that sees the one.
+	run_threads( threads, [&]( const int t ) {
+		uint64_t d = ones_before[ t ];
+		int state;
+		uint64_t *s, first_bit, index, span, block_span, block_left, counts_at_start;
+		bool in_block = false;
+
+		for_each_one<false>( bits, num_bits, first_word[ t ], first_word[ t + 1 ], [&]( const uint64_t p ) {
+			if ( ( d & INVENTORY_MASK ) == 0 || ! in_block ) {
+				in_block = true;
+				index = d >> LOG2_ONES_PER_INVENTORY;
+				first_bit = inventory[ index ];
+				s = &subinventory[ ( inventory[ index ] / 64 ) / 4 ];
+				span = ( inventory[ index + 1 ] / 64 ) / 4 - ( inventory[ index ] / 64 ) / 4;
+				state = -1;
+				counts_at_start = counts[ ( ( inventory[ index ] / 64 ) / 8 ) * 2 ];
+				block_span = ( inventory[ index + 1 ] / 64 ) / 8 - ( inventory[ index ] / 64 ) / 8;
+				block_left = ( inventory[ index ] / 64 ) / 8;
+
+				if ( span >= 512 ) state = 0;
+				else if ( span >= 256 ) state = 1;
+				else if ( span >= 128 ) state = 2;
+				else if ( ( d & INVENTORY_MASK ) != 0 ) {} // Another thread fills counts-based subinventories
+				else if ( span >= 16 ) {
+					assert( ( block_span + 8 & -8LL ) + 8 <= span * 4 );
+
+					int k;
+					for( k = 0; k < block_span; k++ ) {
+						assert( ((uint16_t *)s)[ k + 8 ] == 0 );
+						((uint16_t *)s)[ k + 8 ] = counts[ ( block_left + k + 1 ) * 2 ] - counts_at_start;
+					}
+
+					for( ; k < ( block_span + 8 & -8LL ); k++ ) {
+						assert( ((uint16_t *)s)[ k + 8 ] == 0 );
+						((uint16_t *)s)[ k + 8 ] = 0xFFFFU;
 					}
-					else if ( span >= 2 ) {
-						assert( ( block_span + 8 & -8LL ) <= span * 4 );
-
-						int k;
-						for( k = 0; k < block_span; k++ ) {
-							assert( ((uint16_t *)s)[ k ] == 0 );
-							((uint16_t *)s)[ k ] = counts[ ( block_left + k + 1 ) * 2 ] - counts_at_start;
-						}
-
-						for( ; k < ( block_span + 8 & -8LL ); k++ ) {
-							assert( ((uint16_t *)s)[ k ] == 0 );
-							((uint16_t *)s)[ k ] = 0xFFFFU;
-						}
+
+					assert( block_span / 8 <= 8 );
+
+					for( k = 0; k < block_span / 8; k++ ) {
+						assert( ((uint16_t *)s)[ k ] == 0 );
+						((uint16_t *)s)[ k ] = counts[ ( block_left + ( k + 1 ) * 8 ) * 2 ] - counts_at_start;
+					}
+
+					for( ; k < 8; k++ ) {
+						assert( ((uint16_t *)s)[ k ] == 0 );
+						((uint16_t *)s)[ k ] = 0xFFFFU;
 					}
 				}
+				else if ( span >= 2 ) {
+					assert( ( block_span + 8 & -8LL ) <= span * 4 );
+
+					int k;
+					for( k = 0; k < block_span; k++ ) {
+						assert( ((uint16_t *)s)[ k ] == 0 );
+						((uint16_t *)s)[ k ] = counts[ ( block_left + k + 1 ) * 2 ] - counts_at_start;
+					}
 
-				switch( state ) {
-					case 0: 
-						assert( s[ d & INVENTORY_MASK ] == 0 );
-						s[ d & INVENTORY_MASK ] = i * 64 + j;
-						break;
-					case 1: 
-						assert( ((uint32_t *)s)[ d & INVENTORY_MASK ] == 0 );
-						assert( i * 64 + j - first_bit < (1ULL << 32) );
-						((uint32_t *)s)[ d & INVENTORY_MASK ] = i * 64 + j - first_bit;
-						break;
-					case 2: 
-						assert( ((uint16_t *)s)[ d & INVENTORY_MASK ] == 0 );
-						assert( i * 64 + j - first_bit < (1 << 16) );
-						((uint16_t *)s)[ d & INVENTORY_MASK ] = i * 64 + j - first_bit;
-						break;
+					for( ; k < ( block_span + 8 & -8LL ); k++ ) {
+						assert( ((uint16_t *)s)[ k ] == 0 );
+						((uint16_t *)s)[ k ] = 0xFFFFU;
+					}
 				}
+			}
 
-				d++;
+			switch( state ) {
+				case 0: 
+					assert( s[ d & INVENTORY_MASK ] == 0 );
+					s[ d & INVENTORY_MASK ] = p;
+					break;
+				case 1: 
+					assert( ((uint32_t *)s)[ d & INVENTORY_MASK ] == 0 );
+					assert( p - first_bit < (1ULL << 32) );
+					((uint32_t *)s)[ d & INVENTORY_MASK ] = p - first_bit;
+					break;
+				case 2: 
+					assert( ((uint16_t *)s)[ d & INVENTORY_MASK ] == 0 );
+					assert( p - first_bit < (1 << 16) );
+					((uint16_t *)s)[ d & INVENTORY_MASK ] = p - first_bit;
+					break;
 			}
 
+			d++;
+		} );
+	} );
 
 #ifndef NDEBUG
 	uint64_t r, t;
@@ -199,12 +209,32 @@ rank9sel::rank9sel( const uint64_t * const bits, const uint64_t num_bits ) {
 }
 
 rank9sel::~rank9sel() {
-	delete [] counts;
-	delete [] inventory;
-	delete [] subinventory;
+	if ( ! mapped ) allocator->deallocate( arena, arena_bytes );
+}
+
+rank9sel::rank9sel( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "rank9sel" );
+	num_words = reader.scalar();
+	num_counts = reader.scalar();
+	inventory_size = reader.scalar();
+	counts = reader.array<uint64_t>( num_counts + 1 );
+	inventory = reader.array<uint64_t>( inventory_size + 1 );
+	subinventory = reader.array<uint64_t>( ( num_words + 3 ) / 4 );
+}
+
+void rank9sel::save( sux_writer &writer ) {
+	writer.header( "rank9sel" );
+	writer.scalar( num_words );
+	writer.scalar( num_counts );
+	writer.scalar( inventory_size );
+	writer.array( counts, num_counts + 1 );
+	writer.array( inventory, inventory_size + 1 );
+	writer.array( subinventory, ( num_words + 3 ) / 4 );
 }
 
-uint64_t rank9sel::rank( const uint64_t k ) {
+MULTIVERSION uint64_t rank9sel::rank( const uint64_t k ) {
 	const uint64_t word = k / 64;
 	const uint64_t block = word / 4 & ~1;
 	const int offset = word % 8 - 1;
@@ -212,7 +242,7 @@ uint64_t rank9sel::rank( const uint64_t k ) {
 }
 
 
-uint64_t rank9sel::select( const uint64_t rank ) {
+MULTIVERSION uint64_t rank9sel::select( const uint64_t rank ) {
 	const uint64_t inventory_index_left = rank >> LOG2_ONES_PER_INVENTORY;
 	assert( inventory_index_left < inventory_size );
 
@@ -24,16 +24,26 @@
 #include "popcount.h"
 #include "select.h"
 #include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
 
 class rank9sel {
-private:
+protected:
 	const uint64_t *bits;
 	uint64_t *counts, *inventory, *subinventory;
 	uint64_t num_words, num_counts, inventory_size, ones_per_inventory, log2_ones_per_inventory, num_ones;
+	bool mapped;
+	sux_allocator *allocator;
+	void *arena;
+	uint64_t arena_bytes;
 
 public:
 	rank9sel( const uint64_t * const bits, const uint64_t num_bits );
+	/** Builds the structure using num_threads threads (all cores if nonpositive); the result does not depend on num_threads. */
+	rank9sel( const uint64_t * const bits, const uint64_t num_bits, const int num_threads, sux_allocator &allocator = default_allocator() );
 	~rank9sel();
+	rank9sel( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t rank( const uint64_t pos );
 	uint64_t select( const uint64_t rank );
 	// Just for analysis purposes
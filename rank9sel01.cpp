@@ -0,0 +1,162 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include "rank9sel01.h"
+
+using namespace std;
+
+// Average number of bits between two entries of the zero inventory. Each entry has three
+// subentries, dividing the zeroes of the entry into four parts.
+#define BITS_PER_ZERO_INVENTORY (4096)
+// Between two (sub)entries further apart than this number of blocks we use binary search.
+#define MAX_LINEAR_SCAN (16)
+// Marks entries whose span is too large for 16-bit subentries.
+#define NO_SUBENTRIES (1ULL << 63)
+
+// The number of zeroes in words 0, 0-1, ..., 0-6 of a block without ones, as rank9 relative counts.
+#define FULL_RELATIVE_COUNTS ( 64ULL << 0 | 128ULL << 9 | 192ULL << 18 | 256ULL << 27 | 320ULL << 36 | 384ULL << 45 | 448ULL << 54 )
+
+rank9sel01::rank9sel01( const uint64_t * const bits, const uint64_t num_bits ) : rank9sel01( bits, num_bits, 0 ) {}
+
+rank9sel01::rank9sel01( const uint64_t * const bits, const uint64_t num_bits, const int num_threads, sux_allocator &allocator ) : rank9sel( bits, num_bits, num_threads, allocator ) {
+	num_zeroes = num_bits - counts[ num_counts ];
+	log2_zeroes_per_inventory = max( 2, msb( num_zeroes * BITS_PER_ZERO_INVENTORY / max( num_bits, (uint64_t)1 ) ) );
+	zero_inventory_size = ( num_zeroes + ( 1ULL << log2_zeroes_per_inventory ) - 1 ) >> log2_zeroes_per_inventory;
+
+	printf("Number of zeroes: %lld Number of zeroes per inventory item: %d\n", num_zeroes, 1 << log2_zeroes_per_inventory );
+
+	// Each entry is made of the position of its first zero and of three 16-bit offsets from it.
+	zero_inventory = (uint64_t *)allocator.allocate( ( zero_inventory_size * 2 + 1 ) * sizeof *zero_inventory );
+
+	// Positions of the zeroes of rank multiple of a quarter of an entry, found using the counts:
+	// we look at the bits only in blocks containing such a zero.
+	const int log2_zeroes_per_subentry = log2_zeroes_per_inventory - 2;
+	vector<uint64_t> sample;
+	uint64_t r = 0;
+	for( uint64_t block = 0; r < num_zeroes; block++ ) {
+		const uint64_t end = min( zeroes_before( block + 1 ), num_zeroes );
+		for( ; r < end; r += 1ULL << log2_zeroes_per_subentry ) {
+			uint64_t word = block * 8, z = zeroes_before( block );
+			while( z + 64 - __builtin_popcountll( bits[ word ] ) <= r ) z += 64 - __builtin_popcountll( bits[ word++ ] );
+			sample.push_back( word * 64 + select_in_word( ~bits[ word ], r - z ) );
+		}
+	}
+	// Missing subentries of the last entry point at the end of the bit vector.
+	while( sample.size() < zero_inventory_size * 4 + 1 ) sample.push_back( num_bits );
+
+	uint64_t spans = 0;
+	for( uint64_t i = 0; i < zero_inventory_size; i++ ) {
+		const uint64_t start = sample[ i * 4 ];
+		zero_inventory[ i * 2 ] = start;
+		if ( sample[ i * 4 + 4 ] - start >= 1 << 16 ) {
+			zero_inventory[ i * 2 ] |= NO_SUBENTRIES;
+			spans++;
+		}
+		else for( int j = 1; j < 4; j++ ) zero_inventory[ i * 2 + 1 ] |= sample[ i * 4 + j ] - start << 16 * ( j - 1 );
+	}
+	zero_inventory[ zero_inventory_size * 2 ] = num_bits;
+
+	printf("Inventory entries without subentries: %lld\n", spans );
+
+#ifndef NDEBUG
+	uint64_t z = 0;
+	for( uint64_t i = 0; i < num_bits; i++ ) {
+		if ( ! ( bits[ i / 64 ] >> i % 64 & 1 ) ) {
+			assert( select_zero( z ) == i );
+			z++;
+		}
+	}
+	assert( z == num_zeroes );
+#endif
+}
+
+rank9sel01::~rank9sel01() {
+	if ( ! mapped ) allocator->deallocate( zero_inventory, ( zero_inventory_size * 2 + 1 ) * sizeof *zero_inventory );
+}
+
+rank9sel01::rank9sel01( const uint64_t * const bits, sux_reader &reader ) : rank9sel( bits, reader ) {
+	reader.header( "rank9sel01" );
+	num_zeroes = reader.scalar();
+	zero_inventory_size = reader.scalar();
+	log2_zeroes_per_inventory = reader.scalar();
+	zero_inventory = reader.array<uint64_t>( zero_inventory_size * 2 + 1 );
+}
+
+void rank9sel01::save( sux_writer &writer ) {
+	rank9sel::save( writer );
+	writer.header( "rank9sel01" );
+	writer.scalar( num_zeroes );
+	writer.scalar( zero_inventory_size );
+	writer.scalar( log2_zeroes_per_inventory );
+	writer.array( zero_inventory, zero_inventory_size * 2 + 1 );
+}
+
+MULTIVERSION uint64_t rank9sel01::select_zero( const uint64_t rank ) {
+	const uint64_t inventory_index = rank >> log2_zeroes_per_inventory;
+	assert( inventory_index < zero_inventory_size );
+
+	// The zero lies in [ left .. right ), delimited by entries or subentries.
+	const uint64_t entry = zero_inventory[ inventory_index * 2 ];
+	uint64_t left = entry & ~NO_SUBENTRIES, right = zero_inventory[ inventory_index * 2 + 2 ] & ~NO_SUBENTRIES;
+	if ( ! ( entry & NO_SUBENTRIES ) ) {
+		const uint64_t subentries = zero_inventory[ inventory_index * 2 + 1 ];
+		const int j = rank >> log2_zeroes_per_inventory - 2 & 3;
+		if ( j < 3 ) right = left + ( subentries >> 16 * j & 0xFFFF );
+		if ( j > 0 ) left += subentries >> 16 * ( j - 1 ) & 0xFFFF;
+	}
+	// The zero is most likely close to left: we load its bits while we search the counts.
+	__builtin_prefetch( &bits[ left / 64 ] );
+	__builtin_prefetch( &bits[ left / 64 + 8 ] );
+
+	// The block containing the zero is the last one in [ block_left .. block_right ] with at most rank zeroes before it.
+	uint64_t block_left = left / 512, block_right = right / 512;
+
+	if ( block_right - block_left <= MAX_LINEAR_SCAN ) {
+		while( zeroes_before( block_left + 1 ) <= rank ) block_left++;
+	}
+	else {
+		while( block_right - block_left > 1 ) {
+			const uint64_t middle = ( block_left + block_right ) / 2;
+			if ( zeroes_before( middle ) <= rank ) block_left = middle;
+			else block_right = middle;
+		}
+		if ( zeroes_before( block_right ) <= rank ) block_left = block_right;
+	}
+
+	const uint64_t rank_in_block = rank - zeroes_before( block_left );
+	assert( rank_in_block < 512 );
+	const uint64_t rank_in_block_step_9 = rank_in_block * ONES_STEP_9;
+	const uint64_t subcounts = FULL_RELATIVE_COUNTS - counts[ block_left * 2 + 1 ];
+	const uint64_t offset_in_block = ( ULEQ_STEP_9( subcounts, rank_in_block_step_9 ) * ONES_STEP_9 >> 54 & 0x7 );
+
+	const uint64_t word = block_left * 8 + offset_in_block;
+	const uint64_t rank_in_word = rank_in_block - ( subcounts >> ( offset_in_block - 1 & 7 ) * 9 & 0x1FF );
+	assert( rank_in_word < 64 );
+
+	return word * 64 + select_in_word( ~bits[ word ], rank_in_word );
+}
+
+uint64_t rank9sel01::bit_count() {
+	return rank9sel::bit_count() + ( zero_inventory_size * 2 + 1 ) * 64;
+}
@@ -0,0 +1,58 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef rank9sel01_h
+#define rank9sel01_h
+#include <stdint.h>
+#include "rank9sel.h"
+
+/** A rank9sel that can also select zeroes.
+ *
+ * Zeroes are selected using the counts of rank9sel, complemented on the fly: the number of zeroes
+ * before a block is its starting position minus the number of ones before it, and the same holds
+ * for the relative counts within the block. The only additional data is an inventory recording the
+ * position of a zero every 2<sup>k</sup>, with k chosen so that on average there is an entry every
+ * 4096 bits, and, in 16 bits, the offsets of the zeroes of rank multiple of 2<sup>k-2</sup> in
+ * between. From there the block is found by a linear scan of the counts or, if the (sub)entries
+ * are far apart, by a binary search. */
+
+class rank9sel01 : public rank9sel {
+private:
+	uint64_t *zero_inventory;
+	uint64_t num_zeroes, zero_inventory_size;
+	int log2_zeroes_per_inventory;
+
+	__inline uint64_t zeroes_before( const uint64_t block ) {
+		return block * 512 - counts[ block * 2 ];
+	}
+
+public:
+	rank9sel01( const uint64_t * const bits, const uint64_t num_bits );
+	/** Builds the structure using num_threads threads (all cores if nonpositive) for the rank9sel part. */
+	rank9sel01( const uint64_t * const bits, const uint64_t num_bits, const int num_threads, sux_allocator &allocator = default_allocator() );
+	~rank9sel01();
+	rank9sel01( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
+	uint64_t select_zero( const uint64_t rank );
+	// Just for analysis purposes
+	uint64_t bit_count();
+};
+
+#endif
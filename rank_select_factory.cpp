@@ -0,0 +1,281 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include "rank_select_factory.h"
+#include "macros.h"
+#include "rank9.h"
+#include "rank9sel.h"
+#include "poppy.h"
+#include "simple_select.h"
+#include "jacobson.h"
+#include "elias_fano.h"
+#include "rrr.h"
+#include "hybrid_bit_vector.h"
+#include "run_length_bit_vector.h"
+
+using namespace std;
+
+#define LOG2_CHUNK_BITS (16)
+#define RRR_BLOCK_BITS (63)
+
+// Returns the 64 bits starting at position start, cleared past the last bit.
+__inline static uint64_t read_bits( const uint64_t * const bits, const uint64_t num_bits, const uint64_t start ) {
+	if ( start >= num_bits ) return 0;
+	uint64_t word = bits[ start / 64 ] >> start % 64;
+	if ( start % 64 != 0 && start + 64 - start % 64 < num_bits ) word |= bits[ start / 64 + 1 ] << 64 - start % 64;
+	return num_bits - start < 64 ? word & ( 1ULL << num_bits - start ) - 1 : word;
+}
+
+bit_vector_profile::bit_vector_profile( const uint64_t * const bits, const uint64_t num_bits ) {
+	this->num_bits = num_bits;
+	num_ones = num_runs = rrr_offset_bits = hybrid_data_words = 0;
+	hybrid_chunks[ 0 ] = hybrid_chunks[ 1 ] = hybrid_chunks[ 2 ] = 0;
+	double sum = 0, sum_of_squares = 0;
+	uint64_t carry = 0;
+
+	const uint64_t num_chunks = ( num_bits + ( 1 << LOG2_CHUNK_BITS ) - 1 ) >> LOG2_CHUNK_BITS;
+	for( uint64_t c = 0; c < num_chunks; c++ ) {
+		const int length = min( (uint64_t)1 << LOG2_CHUNK_BITS, num_bits - ( c << LOG2_CHUNK_BITS ) );
+		int ones = 0, runs = 0;
+		for( uint64_t i = c << LOG2_CHUNK_BITS; i < ( c << LOG2_CHUNK_BITS ) + length; i += 64 ) {
+			const uint64_t word = read_bits( bits, num_bits, i );
+			ones += __builtin_popcountll( word );
+			// The first one of each run, in the chunk and in the whole bit vector
+			runs += __builtin_popcountll( word & ~( word << 1 | ( i % ( 1 << LOG2_CHUNK_BITS ) == 0 ? 0 : carry ) ) );
+			num_runs += __builtin_popcountll( word & ~( word << 1 | carry ) );
+			carry = word >> 63;
+		}
+		num_ones += ones;
+		uint64_t words;
+		hybrid_chunks[ hybrid_bit_vector::chunk_type( length, ones, runs, words ) ]++;
+		hybrid_data_words += words;
+		const double d = ones / (double)length;
+		sum += d;
+		sum_of_squares += d * d;
+	}
+
+	// rrr blocks, including the padding block past the end
+	for( uint64_t b = 0; b <= num_bits / RRR_BLOCK_BITS; b++ )
+		rrr_offset_bits += rrr::offset_bits( __builtin_popcountll( read_bits( bits, num_bits, b * RRR_BLOCK_BITS ) & ( 1ULL << RRR_BLOCK_BITS ) - 1 ) );
+
+	density = num_bits == 0 ? 0 : num_ones / (double)num_bits;
+	chunk_density_stddev = num_chunks == 0 ? 0 : sqrt( max( 0., sum_of_squares / num_chunks - ( sum / num_chunks ) * ( sum / num_chunks ) ) );
+}
+
+void bit_vector_profile::print() {
+	printf( "Bits: %lld ones: %lld (density %f) runs: %lld (average length %.1f)\n", num_bits, num_ones, density, num_runs, num_runs == 0 ? 0. : num_ones / (double)num_runs );
+	printf( "Chunk density standard deviation: %f hybrid chunks: raw %lld sparse %lld runs %lld\n", chunk_density_stddev, hybrid_chunks[ 0 ], hybrid_chunks[ 1 ], hybrid_chunks[ 2 ] );
+}
+
+// Latencies in nanoseconds of random ranks and selects on 10^9-bit random vectors of density 0.5,
+// 0.05 and 0.005 (for run_length_bit_vector, of run density 0.25, 0.0475 and 0.005), measured with
+// testranksel; rank9 is assumed to rank like rank9sel. Unsupported operations have latency zero.
+static const double latency[ rank_select_choice::NUM_TYPES ][ 2 ][ 3 ] = {
+	{ { 15, 32, 39 }, { 0, 0, 0 } }, // rank9
+	{ { 15, 32, 39 }, { 69, 257, 34 } }, // rank9sel
+	{ { 26, 72, 89 }, { 71, 186, 301 } }, // poppy
+	{ { 0, 0, 0 }, { 0, 0, 0 } }, // simple_select: see below
+	{ { 39, 78, 87 }, { 0, 0, 0 } }, // jacobson
+	{ { 65, 139, 76 }, { 47, 70, 38 } }, // elias_fano
+	{ { 651, 421, 209 }, { 1010, 624, 481 } }, // rrr
+	{ { 66, 339, 116 }, { 269, 78, 86 } }, // hybrid_bit_vector, without run chunks
+	{ { 592, 659, 229 }, { 538, 384, 160 } } // run_length_bit_vector
+};
+
+// Select latencies of simple_select for each maximum log2 of longwords per subinventory
+static const double simple_select_latency[ 4 ][ 3 ] = { { 118, 179, 336 }, { 67, 113, 243 }, { 45, 115, 150 }, { 35, 84, 13 } };
+// Rank and select latencies of hybrid_bit_vector on run chunks (runs of about 1000 bits)
+static const double hybrid_run_latency[ 2 ] = { 35, 44 };
+
+// Interpolates linearly, in log scale, the values y measured at the three decreasing points x.
+static double interpolate( double p, const double * const x, const double * const y ) {
+	p = max( x[ 2 ], min( x[ 0 ], p ) );
+	const int i = p >= x[ 1 ] ? 0 : 1;
+	const double t = ( log( p ) - log( x[ i + 1 ] ) ) / ( log( x[ i ] ) - log( x[ i + 1 ] ) );
+	return y[ i + 1 ] + t * ( y[ i ] - y[ i + 1 ] );
+}
+
+// Space in bits of an elias_fano instance, following elias_fano::bit_count().
+static uint64_t elias_fano_bits( const uint64_t num_values, const uint64_t universe ) {
+	const int l = max( 0, msb( universe / max( num_values, (uint64_t)1 ) ) );
+	const uint64_t zeroes = universe >> l;
+	return num_values * l + num_values + zeroes + ( ( num_values + 1023 ) / 1024 * 5 + 1 ) * 64 + ( ( zeroes + 1023 ) / 1024 * 5 + 1 ) * 64;
+}
+
+// Space in bits of a simple_select instance, following simple_select::bit_count() but without the spill.
+static uint64_t simple_select_bits( const uint64_t num_bits, const uint64_t num_ones, const int max_log2_longwords_per_subinventory ) {
+	if ( num_bits == 0 ) return 64;
+	const int log2_ones_per_inventory = max( 0, msb( ( num_ones * 8192 + num_bits - 1 ) / num_bits ) );
+	const uint64_t inventory_size = ( num_ones + ( 1ULL << log2_ones_per_inventory ) - 1 ) >> log2_ones_per_inventory;
+	return ( inventory_size * ( ( 1 << min( max_log2_longwords_per_subinventory, max( 0, log2_ones_per_inventory - 2 ) ) ) + 1 ) + 1 ) * 64;
+}
+
+// Space in bits of a jacobson instance, following its constructor.
+static uint64_t jacobson_bits( const uint64_t num_bits ) {
+	const uint64_t block_size = (uint64_t)floor( log( num_bits ) / ( 2 * log( 2 ) ) ), superblock_size = msb( num_bits ) * block_size;
+	return ( num_bits + superblock_size - 1 ) / superblock_size * ceil_log2( num_bits ) + ( num_bits + block_size - 1 ) / block_size * ceil_log2( superblock_size )
+		+ ( 1ULL << block_size ) * block_size * ceil_log2( block_size );
+}
+
+const char *rank_select_choice::name() {
+	static const char * const names[ NUM_TYPES ] = { "rank9", "rank9sel", "poppy", "simple_select", "jacobson", "elias_fano", "rrr", "hybrid_bit_vector", "run_length_bit_vector" };
+	return names[ type ];
+}
+
+double rank_select_choice::predicted_ns( const double rank_fraction ) {
+	return ( rank_fraction == 0 ? 0 : rank_fraction * predicted_rank_ns ) + ( rank_fraction == 1 ? 0 : ( 1 - rank_fraction ) * predicted_select_ns );
+}
+
+void rank_select_choice::print( const uint64_t num_bits, const double rank_fraction ) {
+	char rank[ 16 ] = "-", select[ 16 ] = "-";
+	if ( has_rank ) snprintf( rank, sizeof rank, "%.0f", predicted_rank_ns );
+	if ( has_select ) snprintf( select, sizeof select, "%.0f", predicted_select_ns );
+	printf( "%-21s", name() );
+	if ( type == SIMPLE_SELECT ) printf( " (%d)", parameter );
+	else printf( "    " );
+	printf( " %7.2f%% rank %4s ns select %4s ns mix %4.0f ns%s\n", predicted_bits * 100.0 / max( num_bits, (uint64_t)1 ), rank, select, predicted_ns( rank_fraction ), needs_bits ? " (with the bits)" : "" );
+}
+
+int rank_select_candidates( const bit_vector_profile &profile, const double rank_fraction, rank_select_choice * const candidates ) {
+	const uint64_t n = profile.num_bits, m = profile.num_ones;
+	static const double density_grid[ 3 ] = { .5, .05, .005 }, run_density_grid[ 3 ] = { .25, .0475, .005 };
+	int num_candidates = 0;
+
+	for( int type = 0; type < rank_select_choice::NUM_TYPES; type++ ) {
+		for( int parameter = 0; parameter <= ( type == rank_select_choice::SIMPLE_SELECT ? 3 : 0 ); parameter++ ) {
+			rank_select_choice c;
+			c.type = type;
+			c.parameter = parameter;
+			c.has_rank = type != rank_select_choice::SIMPLE_SELECT;
+			c.has_select = type != rank_select_choice::RANK9 && type != rank_select_choice::JACOBSON;
+			if ( rank_fraction > 0 && ! c.has_rank || rank_fraction < 1 && ! c.has_select ) continue;
+			c.needs_bits = true;
+
+			switch( type ) {
+				case rank_select_choice::RANK9: c.predicted_bits = n + ( n + 511 ) / 512 * 128; break;
+				case rank_select_choice::RANK9SEL: c.predicted_bits = n + ( ( n + 511 ) / 512 * 2 + ( m + 511 ) / 512 + ( n + 63 ) / 64 / 4 ) * 64; break;
+				case rank_select_choice::POPPY: {
+					const uint64_t num_blocks = ( n >> 11 ) + 1;
+					c.predicted_bits = n + ( ( ( num_blocks - 1 ) >> 21 ) + 1 + num_blocks ) * 64 + ( ( m + 8191 ) / 8192 + 1 ) * 32;
+					break;
+				}
+				case rank_select_choice::SIMPLE_SELECT: c.predicted_bits = n + simple_select_bits( n, m, parameter ); break;
+				case rank_select_choice::JACOBSON: c.predicted_bits = n + jacobson_bits( n ); break;
+				case rank_select_choice::ELIAS_FANO: c.predicted_bits = elias_fano_bits( m, n ); c.needs_bits = false; break;
+				case rank_select_choice::RRR: c.predicted_bits = rrr::bit_count( n, m, profile.rrr_offset_bits ); c.needs_bits = false; break;
+				case rank_select_choice::HYBRID: c.predicted_bits = hybrid_bit_vector::bit_count( n, m, profile.hybrid_data_words ); c.needs_bits = false; break;
+				case rank_select_choice::RUN_LENGTH: c.predicted_bits = elias_fano_bits( profile.num_runs, n ) + elias_fano_bits( profile.num_runs + 1, m + 1 ); c.needs_bits = false; break;
+			}
+
+			for( int op = 0; op < 2; op++ ) {
+				double ns;
+				if ( type == rank_select_choice::HYBRID ) {
+					// Run chunks are fast independently of the density.
+					const uint64_t chunks = profile.hybrid_chunks[ 0 ] + profile.hybrid_chunks[ 1 ] + profile.hybrid_chunks[ 2 ];
+					const double runs = chunks == 0 ? 0 : profile.hybrid_chunks[ hybrid_bit_vector::RUN ] / (double)chunks;
+					ns = runs * hybrid_run_latency[ op ] + ( 1 - runs ) * interpolate( profile.density, density_grid, latency[ type ][ op ] );
+				}
+				else if ( type == rank_select_choice::RUN_LENGTH ) ns = interpolate( profile.num_runs / (double)max( n, (uint64_t)1 ), run_density_grid, latency[ type ][ op ] );
+				// The cost of rrr depends on the number of ones or zeroes, whichever is smaller.
+				else if ( type == rank_select_choice::RRR ) ns = interpolate( min( profile.density, 1 - profile.density ), density_grid, latency[ type ][ op ] );
+				else if ( type == rank_select_choice::SIMPLE_SELECT ) ns = op == 0 ? 0 : interpolate( profile.density, density_grid, simple_select_latency[ parameter ] );
+				else ns = interpolate( profile.density, density_grid, latency[ type ][ op ] );
+				( op == 0 ? c.predicted_rank_ns : c.predicted_select_ns ) = ns;
+			}
+
+			candidates[ num_candidates++ ] = c;
+		}
+	}
+
+	return num_candidates;
+}
+
+rank_select_choice choose_rank_select( const bit_vector_profile &profile, const double rank_fraction, const uint64_t max_bits ) {
+	rank_select_choice candidates[ rank_select_choice::NUM_TYPES + 3 ];
+	const int n = rank_select_candidates( profile, rank_fraction, candidates );
+	assert( n > 0 );
+
+	int best = -1, smallest = 0;
+	for( int i = 0; i < n; i++ ) {
+		if ( candidates[ i ].predicted_bits < candidates[ smallest ].predicted_bits ) smallest = i;
+		if ( candidates[ i ].predicted_bits > max_bits ) continue;
+		if ( best == -1 || candidates[ i ].predicted_ns( rank_fraction ) < candidates[ best ].predicted_ns( rank_fraction )
+			|| candidates[ i ].predicted_ns( rank_fraction ) == candidates[ best ].predicted_ns( rank_fraction ) && candidates[ i ].predicted_bits < candidates[ best ].predicted_bits ) best = i;
+	}
+
+	return candidates[ best == -1 ? smallest : best ];
+}
+
+// Adapters from the structures to the rank_select interface.
+
+template<typename T> class rank_select_both : public rank_select {
+	T *t;
+public:
+	rank_select_both( T * const t ) : t( t ) {}
+	~rank_select_both() { delete t; }
+	uint64_t rank( const uint64_t pos ) { return t->rank( pos ); }
+	uint64_t select( const uint64_t rank ) { return t->select( rank ); }
+	uint64_t bit_count() { return t->bit_count(); }
+};
+
+template<typename T> class rank_select_rank : public rank_select {
+	T *t;
+public:
+	rank_select_rank( T * const t ) : t( t ) {}
+	~rank_select_rank() { delete t; }
+	uint64_t rank( const uint64_t pos ) { return t->rank( pos ); }
+	uint64_t select( const uint64_t rank ) {
+		fprintf( stderr, "select() is not supported by this structure\n" );
+		abort();
+	}
+	uint64_t bit_count() { return t->bit_count(); }
+};
+
+template<typename T> class rank_select_select : public rank_select {
+	T *t;
+public:
+	rank_select_select( T * const t ) : t( t ) {}
+	~rank_select_select() { delete t; }
+	uint64_t rank( const uint64_t pos ) {
+		fprintf( stderr, "rank() is not supported by this structure\n" );
+		abort();
+	}
+	uint64_t select( const uint64_t rank ) { return t->select( rank ); }
+	uint64_t bit_count() { return t->bit_count(); }
+};
+
+rank_select *build_rank_select( const rank_select_choice &choice, const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	switch( choice.type ) {
+		case rank_select_choice::RANK9: return new rank_select_rank<rank9>( new rank9( bits, num_bits, 1, allocator ) );
+		case rank_select_choice::RANK9SEL: return new rank_select_both<rank9sel>( new rank9sel( bits, num_bits, 1, allocator ) );
+		case rank_select_choice::POPPY: return new rank_select_both<poppy>( new poppy( bits, num_bits, allocator ) );
+		case rank_select_choice::SIMPLE_SELECT: return new rank_select_select<simple_select>( new simple_select( bits, num_bits, choice.parameter, allocator ) );
+		case rank_select_choice::JACOBSON: return new rank_select_rank<jacobson>( new jacobson( bits, num_bits ) );
+		case rank_select_choice::ELIAS_FANO: return new rank_select_both<elias_fano>( new elias_fano( bits, num_bits, allocator ) );
+		case rank_select_choice::RRR: return new rank_select_both<rrr>( new rrr( bits, num_bits, allocator ) );
+		case rank_select_choice::HYBRID: return new rank_select_both<hybrid_bit_vector>( new hybrid_bit_vector( bits, num_bits, allocator ) );
+		default: return new rank_select_both<run_length_bit_vector>( new run_length_bit_vector( bits, num_bits, allocator ) );
+	}
+}
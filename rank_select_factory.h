@@ -0,0 +1,97 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef rank_select_factory_h
+#define rank_select_factory_h
+#include <stdint.h>
+#include "allocator.h"
+
+/** Statistics of a bit vector that drive the choice of a rank/select structure.
+ *
+ * A single pass computes the density, the standard deviation of the density of chunks of 2^16
+ * bits, the number of runs of ones and the exact space of the structures whose space depends on
+ * the distribution of the ones (rrr and hybrid_bit_vector). */
+
+class bit_vector_profile {
+public:
+	uint64_t num_bits, num_ones, num_runs;
+	double density, chunk_density_stddev;
+	// Sum of rrr::offset_bits() over the blocks
+	uint64_t rrr_offset_bits;
+	// Sum of the data words of the chunks of a hybrid_bit_vector, and number of chunks of each type
+	uint64_t hybrid_data_words, hybrid_chunks[ 3 ];
+
+	bit_vector_profile( const uint64_t * const bits, const uint64_t num_bits );
+	void print();
+};
+
+/** A rank/select structure built by build_rank_select(). Structures supporting just one of the
+ * operations abort on the other one. */
+
+class rank_select {
+public:
+	virtual ~rank_select() {}
+	virtual uint64_t rank( const uint64_t pos ) = 0;
+	virtual uint64_t select( const uint64_t rank ) = 0;
+	/** Returns the number of bits used by the structure, excluding the bit vector. */
+	virtual uint64_t bit_count() = 0;
+};
+
+/** A candidate structure, with the prediction the choice is based on.
+ *
+ * Predicted latencies are for random queries on large bit vectors; they come from a table of
+ * timings on 10^9-bit vectors, interpolated on the density, so they are meaningful mostly in
+ * relative terms. Predicted space is exact for rank9, rank9sel, poppy, jacobson, elias_fano,
+ * rrr, hybrid_bit_vector and run_length_bit_vector, and a lower bound for simple_select,
+ * whose spill depends on the distribution of the ones. */
+
+class rank_select_choice {
+public:
+	enum { RANK9, RANK9SEL, POPPY, SIMPLE_SELECT, JACOBSON, ELIAS_FANO, RRR, HYBRID, RUN_LENGTH, NUM_TYPES };
+	int type;
+	// The maximum log2 of longwords per subinventory, for simple_select
+	int parameter;
+	bool has_rank, has_select;
+	// Whether the structure needs the bit vector at query time
+	bool needs_bits;
+	// Predicted space, including the bit vector if needed
+	uint64_t predicted_bits;
+	double predicted_rank_ns, predicted_select_ns;
+
+	const char *name();
+	/** Returns the predicted average time of a query when a fraction rank_fraction of the queries are ranks. */
+	double predicted_ns( const double rank_fraction );
+	void print( const uint64_t num_bits, const double rank_fraction );
+};
+
+/** Stores in candidates (which must have room for rank_select_choice::NUM_TYPES + 3 elements)
+ * the structures supporting the operations needed by a query mix in which a fraction
+ * rank_fraction of the queries are ranks, with their predictions, and returns their number. */
+int rank_select_candidates( const bit_vector_profile &profile, const double rank_fraction, rank_select_choice * const candidates );
+
+/** Returns the candidate with smallest predicted query time among those whose predicted space
+ * (including the bit vector, if needed) is at most max_bits; ties go to the smaller structure.
+ * If no candidate fits, returns the smallest one. */
+rank_select_choice choose_rank_select( const bit_vector_profile &profile, const double rank_fraction, const uint64_t max_bits = UINT64_MAX );
+
+/** Builds the chosen structure. If choice.needs_bits, the bit vector must outlive the structure. */
+rank_select *build_rank_select( const rank_select_choice &choice, const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+
+#endif
@@ -0,0 +1,284 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cassert>
+#include "rrr.h"
+#include "select.h"
+
+#define BLOCK_BITS (63)
+#define LOG2_BLOCKS_PER_SUPERBLOCK (5)
+#define LOG2_ONES_PER_INVENTORY (10)
+#define MAX_BRANCHING_ONES (16)
+
+// Binomial coefficients up to the block size, and the number of bits of the offsets of each class.
+// Coefficients are indexed by k first, so that the rows used by decoding (k <= 31) are contiguous.
+static struct binomial_table {
+	uint64_t c[ BLOCK_BITS + 1 ][ BLOCK_BITS + 1 ];
+	int width[ BLOCK_BITS + 1 ];
+
+	binomial_table() {
+		for( int n = 0; n <= BLOCK_BITS; n++ ) {
+			c[ 0 ][ n ] = 1;
+			for( int k = 1; k <= BLOCK_BITS; k++ ) c[ k ][ n ] = n == 0 ? 0 : c[ k - 1 ][ n - 1 ] + c[ k ][ n - 1 ];
+		}
+		for( int k = 0; k <= BLOCK_BITS; k++ ) width[ k ] = ceil_log2( c[ k ][ BLOCK_BITS ] );
+	}
+} binomial;
+
+// Blocks with at most half ones are enumerated in colexicographical order, that is, by the
+// combinatorial number system: a block with ones in positions p_1 < p_2 < ... < p_c has offset
+// C( p_1, 1 ) + C( p_2, 2 ) + ... + C( p_c, c ). Other blocks are complemented first.
+__inline static uint64_t encode( uint64_t block, const int c ) {
+	if ( c > BLOCK_BITS / 2 ) block = ~block & ( 1ULL << BLOCK_BITS ) - 1;
+	uint64_t offset = 0;
+	for( int j = 1; block != 0; j++ ) {
+		offset += binomial.c[ j ][ __builtin_ctzll( block ) ];
+		block &= block - 1;
+	}
+	return offset;
+}
+
+// Decodes the bits of a block in positions from stop (inclusive) to the end; the other bits are zero.
+// We scan positions top-down: with k ones left, position n is a one iff C( n, k ) <= offset. The
+// scan stops as soon as stop is reached or no ones are left, so rank and get decode on average
+// half a block, and sparse blocks just up to their lowest one (or zero, if complemented). Ones
+// are mispredicted branches, so blocks with many of them are decoded without branches.
+__inline static uint64_t decode( uint64_t offset, const int c, const int stop ) {
+	uint64_t block = 0;
+	int k = c > BLOCK_BITS / 2 ? BLOCK_BITS - c : c, n = BLOCK_BITS - 1;
+	if ( k > MAX_BRANCHING_ONES ) {
+		for( ; k != 0 && n >= stop; n-- ) {
+			const uint64_t coeff = binomial.c[ k ][ n ], one = offset >= coeff;
+			offset -= coeff & -one;
+			block |= one << n;
+			k -= one;
+		}
+	}
+	else {
+		for( ; k != 0 && n >= stop; n-- ) {
+			const uint64_t coeff = binomial.c[ k ][ n ];
+			if ( offset >= coeff ) {
+				offset -= coeff;
+				block |= 1ULL << n;
+				k--;
+			}
+		}
+	}
+	return c > BLOCK_BITS / 2 ? ~block & ( 1ULL << BLOCK_BITS ) - ( 1ULL << stop ) : block;
+}
+
+// Returns the bits of a block, padding with zeroes past the end of the bit vector.
+__inline static uint64_t read_block( const uint64_t * const bits, const uint64_t num_bits, const uint64_t block ) {
+	const uint64_t start = block * BLOCK_BITS;
+	if ( start >= num_bits ) return 0;
+	uint64_t word = bits[ start / 64 ] >> start % 64;
+	if ( start % 64 > 64 - BLOCK_BITS && start + 64 - start % 64 < num_bits ) word |= bits[ start / 64 + 1 ] << 64 - start % 64;
+	word &= ( 1ULL << BLOCK_BITS ) - 1;
+	if ( num_bits - start < BLOCK_BITS ) word &= ( 1ULL << num_bits - start ) - 1;
+	return word;
+}
+
+rrr::rrr() {}
+
+rrr::rrr( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
+	this->num_bits = num_bits;
+	// There is always a block past the last bit, so that rank( num_bits ) needs no special case.
+	num_blocks = num_bits / BLOCK_BITS + 1;
+	num_superblocks = ( ( num_blocks - 1 ) >> LOG2_BLOCKS_PER_SUPERBLOCK ) + 1;
+
+	// A first pass computes the size of the offsets.
+	num_ones = num_offset_bits = 0;
+	for( uint64_t b = 0; b < num_blocks; b++ ) {
+		const int c = __builtin_popcountll( read_block( bits, num_bits, b ) );
+		num_ones += c;
+		num_offset_bits += binomial.width[ c ];
+	}
+
+	rank_width = ceil_log2( num_ones + 1 );
+	pointer_width = ceil_log2( num_offset_bits + 1 );
+	// One entry every 1024 ones, plus a sentinel.
+	inventory_size = ( ( num_ones + ( 1 << LOG2_ONES_PER_INVENTORY ) - 1 ) >> LOG2_ONES_PER_INVENTORY ) + 1;
+	inventory_width = ceil_log2( num_superblocks );
+
+	printf( "Number of ones: %lld Number of blocks: %lld Offset bits: %lld (%.2f%%)\n", num_ones, num_blocks, num_offset_bits, num_offset_bits * 100.0 / num_bits );
+
+	// Each array has a spare word, as get_bits() might read past the last bit.
+	const uint64_t classes_words = ( num_blocks * 6 + 63 ) / 64 + 1;
+	const uint64_t offsets_words = ( num_offset_bits + 63 ) / 64 + 1;
+	const uint64_t samples_words = ( num_superblocks * ( rank_width + pointer_width ) + 63 ) / 64 + 1;
+	const uint64_t inventory_words = ( inventory_size * inventory_width + 63 ) / 64 + 1;
+	arena_bytes = cache_align( classes_words * sizeof *classes ) + cache_align( offsets_words * sizeof *offsets ) + cache_align( samples_words * sizeof *samples ) + cache_align( inventory_words * sizeof *inventory );
+	arena = allocator.allocate( arena_bytes );
+	arena_allocator layout( arena, arena_bytes, true );
+	classes = (uint64_t *)layout.allocate( classes_words * sizeof *classes );
+	offsets = (uint64_t *)layout.allocate( offsets_words * sizeof *offsets );
+	samples = (uint64_t *)layout.allocate( samples_words * sizeof *samples );
+	inventory = (uint64_t *)layout.allocate( inventory_words * sizeof *inventory );
+
+	uint64_t r = 0, pos = 0;
+	for( uint64_t b = 0; b < num_blocks; b++ ) {
+		if ( ( b & ( 1 << LOG2_BLOCKS_PER_SUPERBLOCK ) - 1 ) == 0 ) {
+			const uint64_t s = ( b >> LOG2_BLOCKS_PER_SUPERBLOCK ) * ( rank_width + pointer_width );
+			set_bits( samples, s, rank_width, r );
+			set_bits( samples, s + rank_width, pointer_width, pos );
+		}
+		const uint64_t block = read_block( bits, num_bits, b );
+		const int c = __builtin_popcountll( block );
+		set_bits( classes, b * 6, 6, c );
+		set_bits( offsets, pos, binomial.width[ c ], encode( block, c ) );
+		r += c;
+		pos += binomial.width[ c ];
+	}
+
+	assert( r == num_ones );
+	assert( pos == num_offset_bits );
+
+	// Entry i is the last superblock starting with at most i * 1024 ones before it.
+	uint64_t i = 0;
+	for( uint64_t s = 0; s < num_superblocks; s++ ) {
+		const uint64_t next = s + 1 < num_superblocks ? get_bits( samples, ( s + 1 ) * ( rank_width + pointer_width ), rank_width ) : num_ones;
+		while( i << LOG2_ONES_PER_INVENTORY < next ) set_bits( inventory, i++ * inventory_width, inventory_width, s );
+	}
+	assert( i == inventory_size - 1 );
+	set_bits( inventory, i * inventory_width, inventory_width, num_superblocks - 1 );
+
+#ifndef NDEBUG
+	r = 0;
+	for( uint64_t i = 0; i < num_bits; i++ ) {
+		assert( rank( i ) == r );
+		const bool bit = bits[ i / 64 ] >> i % 64 & 1;
+		assert( get( i ) == bit );
+		if ( bit ) {
+			assert( select( r ) == i );
+			r++;
+		}
+	}
+	assert( rank( num_bits ) == r );
+#endif
+}
+
+rrr::~rrr() {
+	if ( ! mapped ) allocator->deallocate( arena, arena_bytes );
+}
+
+rrr::rrr( sux_reader &reader ) {
+	mapped = true;
+	reader.header( "rrr" );
+	num_bits = reader.scalar();
+	num_blocks = reader.scalar();
+	num_superblocks = reader.scalar();
+	num_ones = reader.scalar();
+	num_offset_bits = reader.scalar();
+	rank_width = reader.scalar();
+	pointer_width = reader.scalar();
+	inventory_size = reader.scalar();
+	inventory_width = reader.scalar();
+	classes = reader.array<uint64_t>( ( num_blocks * 6 + 63 ) / 64 + 1 );
+	offsets = reader.array<uint64_t>( ( num_offset_bits + 63 ) / 64 + 1 );
+	samples = reader.array<uint64_t>( ( num_superblocks * ( rank_width + pointer_width ) + 63 ) / 64 + 1 );
+	inventory = reader.array<uint64_t>( ( inventory_size * inventory_width + 63 ) / 64 + 1 );
+}
+
+void rrr::save( sux_writer &writer ) {
+	writer.header( "rrr" );
+	writer.scalar( num_bits );
+	writer.scalar( num_blocks );
+	writer.scalar( num_superblocks );
+	writer.scalar( num_ones );
+	writer.scalar( num_offset_bits );
+	writer.scalar( rank_width );
+	writer.scalar( pointer_width );
+	writer.scalar( inventory_size );
+	writer.scalar( inventory_width );
+	writer.array( classes, ( num_blocks * 6 + 63 ) / 64 + 1 );
+	writer.array( offsets, ( num_offset_bits + 63 ) / 64 + 1 );
+	writer.array( samples, ( num_superblocks * ( rank_width + pointer_width ) + 63 ) / 64 + 1 );
+	writer.array( inventory, ( inventory_size * inventory_width + 63 ) / 64 + 1 );
+}
+
+MULTIVERSION uint64_t rrr::rank( const uint64_t k ) {
+	const uint64_t block = k / BLOCK_BITS;
+	const uint64_t superblock = block >> LOG2_BLOCKS_PER_SUPERBLOCK;
+	const uint64_t s = superblock * ( rank_width + pointer_width );
+	uint64_t r = get_bits( samples, s, rank_width ), pos = get_bits( samples, s + rank_width, pointer_width );
+
+	for( uint64_t b = superblock << LOG2_BLOCKS_PER_SUPERBLOCK; b < block; b++ ) {
+		const int c = block_class( b );
+		r += c;
+		pos += binomial.width[ c ];
+	}
+
+	const int c = block_class( block );
+	// The ones before k are those of the block minus those from k on.
+	return r + c - __builtin_popcountll( decode( get_bits( offsets, pos, binomial.width[ c ] ), c, k % BLOCK_BITS ) );
+}
+
+MULTIVERSION uint64_t rrr::select( const uint64_t rank ) {
+	assert( rank < num_ones );
+	const int width = rank_width + pointer_width;
+	// The last superblock starting with at most rank ones before it, between two inventory entries
+	const uint64_t i = rank >> LOG2_ONES_PER_INVENTORY;
+	uint64_t left = get_bits( inventory, i * inventory_width, inventory_width ), right = get_bits( inventory, ( i + 1 ) * inventory_width, inventory_width ) + 1;
+	while( right - left > 1 ) {
+		const uint64_t middle = ( left + right ) / 2;
+		if ( get_bits( samples, middle * width, rank_width ) <= rank ) left = middle;
+		else right = middle;
+	}
+
+	uint64_t r = get_bits( samples, left * width, rank_width ), pos = get_bits( samples, left * width + rank_width, pointer_width );
+	uint64_t b = left << LOG2_BLOCKS_PER_SUPERBLOCK;
+	int c;
+	while( r + ( c = block_class( b ) ) <= rank ) {
+		r += c;
+		pos += binomial.width[ c ];
+		b++;
+	}
+
+	return b * BLOCK_BITS + select_in_word( decode( get_bits( offsets, pos, binomial.width[ c ] ), c, 0 ), rank - r );
+}
+
+MULTIVERSION bool rrr::get( const uint64_t k ) {
+	const uint64_t block = k / BLOCK_BITS;
+	const uint64_t superblock = block >> LOG2_BLOCKS_PER_SUPERBLOCK;
+	uint64_t pos = get_bits( samples, superblock * ( rank_width + pointer_width ) + rank_width, pointer_width );
+	for( uint64_t b = superblock << LOG2_BLOCKS_PER_SUPERBLOCK; b < block; b++ ) pos += binomial.width[ block_class( b ) ];
+
+	const int c = block_class( block );
+	return decode( get_bits( offsets, pos, binomial.width[ c ] ), c, k % BLOCK_BITS ) >> k % BLOCK_BITS & 1;
+}
+
+uint64_t rrr::bit_count() {
+	return num_blocks * 6 + num_offset_bits + num_superblocks * ( rank_width + pointer_width ) + inventory_size * inventory_width;
+}
+
+int rrr::offset_bits( const int ones ) {
+	return binomial.width[ ones ];
+}
+
+uint64_t rrr::bit_count( const uint64_t num_bits, const uint64_t num_ones, const uint64_t num_offset_bits ) {
+	const uint64_t num_blocks = num_bits / BLOCK_BITS + 1, num_superblocks = ( ( num_blocks - 1 ) >> LOG2_BLOCKS_PER_SUPERBLOCK ) + 1;
+	const uint64_t inventory_size = ( ( num_ones + ( 1 << LOG2_ONES_PER_INVENTORY ) - 1 ) >> LOG2_ONES_PER_INVENTORY ) + 1;
+	return num_blocks * 6 + num_offset_bits + num_superblocks * ( ceil_log2( num_ones + 1 ) + ceil_log2( num_offset_bits + 1 ) ) + inventory_size * ceil_log2( num_superblocks );
+}
+
+void rrr::print_counts() {}
@@ -0,0 +1,100 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef rrr_h
+#define rrr_h
+#include <stdint.h>
+#include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
+
+/** A compressed bit vector with rank, select and access, following Raman, Raman and Rao.
+ *
+ * The bit vector is split into blocks of 63 bits. Each block is represented by its class (its
+ * number of ones, in 6 bits) and by an offset identifying it among the blocks of the same class,
+ * in the enumerative order; the offset needs just enough bits to represent the number of blocks
+ * of the class, so the total space is close to the zero-order empirical entropy. Every 32 blocks
+ * we sample the number of ones before the block and the position of its offset, in bit-packed
+ * counters. Offsets are decoded using a table of binomial coefficients. A sparse inventory records
+ * the superblock containing every 1024th one, so that select searches just a few samples.
+ *
+ * The bit vector is not needed after construction. */
+
+class rrr {
+private:
+	uint64_t *classes, *offsets, *samples, *inventory;
+	uint64_t num_bits, num_blocks, num_superblocks, num_ones, num_offset_bits, inventory_size;
+	int rank_width, pointer_width, inventory_width;
+	bool mapped;
+	sux_allocator *allocator;
+	void *arena;
+	uint64_t arena_bytes;
+
+	__inline static uint64_t get_bits( const uint64_t * const bits, const uint64_t start, const int width ) {
+		const uint64_t start_word = start / 64;
+		const int start_bit = start % 64;
+		const int total_offset = start_bit + width;
+		const uint64_t result = bits[ start_word ] >> start_bit;
+		return ( total_offset <= 64 ? result : result | bits[ start_word + 1 ] << 64 - start_bit ) & ( 1ULL << width ) - 1;
+	}
+
+	__inline static void set_bits( uint64_t * const bits, const uint64_t start, const int width, const uint64_t value ) { 
+		if ( width == 0 ) return;
+		const uint64_t start_word = start / 64;
+		const uint64_t end_word = ( start + width - 1 ) / 64;
+		const uint64_t start_bit = start % 64;
+
+		if ( start_word == end_word ) {
+			bits[ start_word ] &= ~ ( ( ( 1ULL << width ) - 1 ) << start_bit );
+			bits[ start_word ] |= value << start_bit;
+		}
+		else {
+			// Here start_bit > 0.
+			bits[ start_word ] &= ( 1ULL << start_bit ) - 1;
+			bits[ start_word ] |= value << start_bit;
+			bits[ end_word ] &=  - ( 1ULL << width - 64 + start_bit );
+			bits[ end_word ] |= value >> 64 - start_bit;
+		}
+	}
+
+	__inline int block_class( const uint64_t block ) {
+		return get_bits( classes, block * 6, 6 );
+	}
+
+public:
+	rrr();
+	rrr( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+	~rrr();
+	rrr( sux_reader &reader );
+	void save( sux_writer &writer );
+	uint64_t rank( const uint64_t pos );
+	uint64_t select( const uint64_t rank );
+	bool get( const uint64_t pos );
+	// Just for analysis purposes
+	void print_counts();
+	uint64_t bit_count();
+	/** Returns the number of bits of the offset of a block of 63 bits with given number of ones. */
+	static int offset_bits( const int ones );
+	/** Returns the number of bits used by an instance with given parameters, where num_offset_bits is
+	 * the sum of offset_bits() over the blocks of 63 bits (the last one padded with zeroes). */
+	static uint64_t bit_count( const uint64_t num_bits, const uint64_t num_ones, const uint64_t num_offset_bits );
+};
+
+#endif
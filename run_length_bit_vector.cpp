@@ -0,0 +1,128 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include "run_length_bit_vector.h"
+
+using namespace std;
+
+// Returns word i of the bit vector, cleared past the last bit.
+__inline static uint64_t read_word( const uint64_t * const bits, const uint64_t num_bits, const uint64_t i ) {
+	return i * 64 + 64 <= num_bits ? bits[ i ] : bits[ i ] & ( 1ULL << num_bits % 64 ) - 1;
+}
+
+run_length_bit_vector::run_length_bit_vector( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	this->num_bits = num_bits;
+	const uint64_t num_words = ( num_bits + 63 ) / 64;
+
+	vector<uint64_t> start, before;
+	num_ones = 0;
+	uint64_t carry = 0;
+	for( uint64_t i = 0; i < num_words; i++ ) {
+		const uint64_t word = read_word( bits, num_bits, i );
+		// The first one of each run
+		for( uint64_t starts = word & ~( word << 1 | carry ); starts != 0; starts &= starts - 1 ) {
+			const int s = __builtin_ctzll( starts );
+			start.push_back( i * 64 + s );
+			before.push_back( num_ones + __builtin_popcountll( word & ( 1ULL << s ) - 1 ) );
+		}
+		num_ones += __builtin_popcountll( word );
+		carry = word >> 63;
+	}
+
+	num_runs = start.size();
+	before.push_back( num_ones );
+
+	printf( "Number of ones: %lld Number of runs: %lld\n", num_ones, num_runs );
+
+	starts = new elias_fano( start.data(), num_runs, num_bits, allocator );
+	ones_before = new elias_fano( before.data(), num_runs + 1, num_ones + 1, allocator );
+
+#ifndef NDEBUG
+	uint64_t r = 0;
+	for( uint64_t i = 0; i < num_bits; i++ ) {
+		assert( rank( i ) == r );
+		const bool bit = bits[ i / 64 ] >> i % 64 & 1;
+		assert( get( i ) == bit );
+		if ( bit ) {
+			assert( select( r ) == i );
+			r++;
+		}
+	}
+	assert( rank( num_bits ) == r );
+#endif
+}
+
+run_length_bit_vector::~run_length_bit_vector() {
+	delete starts;
+	delete ones_before;
+}
+
+run_length_bit_vector::run_length_bit_vector( sux_reader &reader ) {
+	reader.header( "run_length_bit_vector" );
+	num_bits = reader.scalar();
+	num_runs = reader.scalar();
+	num_ones = reader.scalar();
+	starts = new elias_fano( reader );
+	ones_before = new elias_fano( reader );
+}
+
+void run_length_bit_vector::save( sux_writer &writer ) {
+	writer.header( "run_length_bit_vector" );
+	writer.scalar( num_bits );
+	writer.scalar( num_runs );
+	writer.scalar( num_ones );
+	starts->save( writer );
+	ones_before->save( writer );
+}
+
+MULTIVERSION uint64_t run_length_bit_vector::rank( const uint64_t pos ) {
+	// The runs starting before pos
+	const uint64_t j = starts->rank( pos );
+	if ( j == 0 ) return 0;
+	uint64_t next;
+	const uint64_t r = ones_before->select( j - 1, &next );
+	return r + min( pos - starts->select( j - 1 ), next - r );
+}
+
+MULTIVERSION uint64_t run_length_bit_vector::select( const uint64_t rank ) {
+	assert( rank < num_ones );
+	// The last run with at most rank ones before it
+	const uint64_t j = ones_before->rank( rank + 1 ) - 1;
+	return starts->select( j ) + rank - ones_before->select( j );
+}
+
+MULTIVERSION bool run_length_bit_vector::get( const uint64_t pos ) {
+	// The runs starting at or before pos
+	const uint64_t j = starts->rank( pos + 1 );
+	if ( j == 0 ) return false;
+	uint64_t next;
+	const uint64_t r = ones_before->select( j - 1, &next );
+	return pos - starts->select( j - 1 ) < next - r;
+}
+
+uint64_t run_length_bit_vector::bit_count() {
+	return starts->bit_count() + ones_before->bit_count();
+}
+
+void run_length_bit_vector::print_counts() {}
@@ -0,0 +1,58 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef run_length_bit_vector_h
+#define run_length_bit_vector_h
+#include <stdint.h>
+#include "macros.h"
+#include "elias_fano.h"
+#include "serialize.h"
+#include "allocator.h"
+
+/** A bit vector represented by its runs of ones, with rank, select and access.
+ *
+ * The starting positions of the runs and the number of ones before each run (followed by the
+ * number of ones) are stored in two elias_fano instances, so the space is O(r log(n / r)) bits
+ * for r runs in n bits, independently of the number of ones. A query costs a rank or select on
+ * one sequence and one or two selections on the other.
+ *
+ * The bit vector is not needed after construction. */
+
+class run_length_bit_vector {
+private:
+	elias_fano *starts, *ones_before;
+	uint64_t num_bits, num_runs, num_ones;
+
+public:
+	run_length_bit_vector( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+	~run_length_bit_vector();
+	run_length_bit_vector( sux_reader &reader );
+	void save( sux_writer &writer );
+	uint64_t rank( const uint64_t pos );
+	uint64_t select( const uint64_t rank );
+	bool get( const uint64_t pos );
+	/** Returns the number of runs of ones. */
+	uint64_t runs() { return num_runs; }
+	// Just for analysis purposes
+	void print_counts();
+	uint64_t bit_count();
+};
+
+#endif
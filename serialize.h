@@ -0,0 +1,176 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef serialize_h
+#define serialize_h
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* On-disk format.
+ *
+ * Each structure starts with a header of SUX_ALIGNMENT bytes containing the magic string "SUX\0",
+ * the format version (a 32-bit integer) and the name of the class, zero-padded. The header is followed
+ * by the scalar fields of the structure (64-bit integers) and by its arrays; each array is preceded by
+ * its length in bytes and starts at a multiple of SUX_ALIGNMENT bytes. Nested structures (e.g., the
+ * selection structures of elias_fano) follow, each with its own header. Several structures can be
+ * written one after the other in the same file.
+ *
+ * Data is written in native byte order. Loaded structures point straight into the mapping, so
+ * the mapping must outlive them; they are read-only. */
+
+#define SUX_FORMAT_VERSION (1)
+#define SUX_ALIGNMENT (64)
+#define SUX_MAGIC "SUX"
+#define SUX_TYPE_LENGTH ( SUX_ALIGNMENT - 8 )
+
+class sux_writer {
+private:
+	FILE *file;
+	uint64_t offset;
+
+	void write( const void * const data, const uint64_t bytes ) {
+		if ( fwrite( data, 1, bytes, file ) != bytes ) {
+			perror( "sux_writer" );
+			abort();
+		}
+		offset += bytes;
+	}
+
+	void align() {
+		static const char zeroes[ SUX_ALIGNMENT ] = {};
+		if ( offset % SUX_ALIGNMENT != 0 ) write( zeroes, SUX_ALIGNMENT - offset % SUX_ALIGNMENT );
+	}
+
+public:
+	/** Creates a writer appending to file, whose position must be a multiple of SUX_ALIGNMENT. */
+	sux_writer( FILE * const file ) : file( file ), offset( ftell( file ) ) {}
+
+	void header( const char * const type ) {
+		char header[ SUX_ALIGNMENT ] = SUX_MAGIC;
+		const uint32_t version = SUX_FORMAT_VERSION;
+		align();
+		memcpy( header + 4, &version, sizeof version );
+		strncpy( header + 8, type, SUX_TYPE_LENGTH - 1 );
+		write( header, SUX_ALIGNMENT );
+	}
+
+	void scalar( const uint64_t x ) {
+		write( &x, sizeof x );
+	}
+
+	template<typename T> void array( const T * const data, const uint64_t length ) {
+		scalar( length * sizeof *data );
+		align();
+		write( data, length * sizeof *data );
+	}
+};
+
+class sux_reader {
+private:
+	const char *data;
+	uint64_t length, offset;
+
+	__inline static void fail( const char * const message, const char * const type ) {
+		fprintf( stderr, "sux_reader: %s (%s)\n", message, type );
+		abort();
+	}
+
+	const char *read( const uint64_t bytes ) {
+		if ( offset + bytes > length ) fail( "truncated data", "" );
+		const char * const p = data + offset;
+		offset += bytes;
+		return p;
+	}
+
+	void align() {
+		offset = ( offset + SUX_ALIGNMENT - 1 ) & -(uint64_t)SUX_ALIGNMENT;
+	}
+
+public:
+	/** Creates a reader on length bytes starting at data, which must be aligned to SUX_ALIGNMENT bytes. */
+	sux_reader( const void * const data, const uint64_t length ) : data( (const char *)data ), length( length ), offset( 0 ) {}
+
+	/** Checks the header of a structure of the given type; a mismatch is a fatal error. */
+	void header( const char * const type ) {
+		align();
+		const char * const header = read( SUX_ALIGNMENT );
+		uint32_t version;
+		memcpy( &version, header + 4, sizeof version );
+		if ( memcmp( header, SUX_MAGIC, 4 ) != 0 ) fail( "bad magic", type );
+		if ( version != SUX_FORMAT_VERSION ) fail( "unsupported format version", type );
+		if ( strncmp( header + 8, type, SUX_TYPE_LENGTH ) != 0 ) fail( "type mismatch", type );
+	}
+
+	uint64_t scalar() {
+		uint64_t x;
+		memcpy( &x, read( sizeof x ), sizeof x );
+		return x;
+	}
+
+	/** Returns a pointer into the data to an array of given length, which must match the stored one. */
+	template<typename T> T *array( const uint64_t length ) {
+		if ( scalar() != length * sizeof( T ) ) fail( "array length mismatch", "" );
+		align();
+		return length == 0 ? NULL : (T *)read( length * sizeof( T ) );
+	}
+};
+
+/** A read-only memory mapping of a whole file. */
+class sux_mapped_file {
+private:
+	void *address;
+	uint64_t length;
+
+public:
+	sux_mapped_file( const char * const path ) : address( NULL ), length( 0 ) {
+		const int fd = open( path, O_RDONLY );
+		struct stat st;
+		if ( fd == -1 || fstat( fd, &st ) == -1 ) {
+			perror( path );
+			if ( fd != -1 ) close( fd );
+			return;
+		}
+
+		length = st.st_size;
+		if ( length != 0 && ( address = mmap( NULL, length, PROT_READ, MAP_SHARED, fd, 0 ) ) == MAP_FAILED ) {
+			perror( path );
+			address = NULL;
+		}
+		close( fd );
+	}
+
+	~sux_mapped_file() {
+		if ( address != NULL ) munmap( address, length );
+	}
+
+	/** Returns whether the file was mapped successfully. */
+	bool ok() { return address != NULL; }
+	const void *data() { return address; }
+	uint64_t size() { return length; }
+	sux_reader reader() { return sux_reader( address, length ); }
+};
+
+#endif
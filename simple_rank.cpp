@@ -27,13 +27,15 @@
 
 simple_rank::simple_rank() {}
 
-simple_rank::simple_rank( const uint64_t * const bits, const uint64_t num_bits ) {
+simple_rank::simple_rank( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
 	this->bits = bits;
 	int num_words = ( num_bits + 63 ) / 64;
 	num_counts = num_words >> LOG2_LONGWORDS_PER_ENTRY;
 	
 	// Init rank structure
-	counts = new uint64_t[ num_counts + 2 ]();
+	counts = (uint64_t *)allocator.allocate( ( num_counts + 2 ) * sizeof *counts );
 
 	uint64_t c = 0;
 	uint64_t pos = 0;
@@ -50,11 +52,25 @@ simple_rank::simple_rank( const uint64_t * const bits, const uint64_t num_bits )
 }
 
 simple_rank::~simple_rank() {
-	delete [] counts;
+	if ( ! mapped ) allocator->deallocate( counts, ( num_counts + 2 ) * sizeof *counts );
+}
+
+simple_rank::simple_rank( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "simple_rank" );
+	num_counts = reader.scalar();
+	counts = reader.array<uint64_t>( num_counts + 2 );
+}
+
+void simple_rank::save( sux_writer &writer ) {
+	writer.header( "simple_rank" );
+	writer.scalar( num_counts );
+	writer.array( counts, num_counts + 2 );
 }
 
 
-uint64_t simple_rank::rank( const uint64_t k ) {
+MULTIVERSION uint64_t simple_rank::rank( const uint64_t k ) {
 	const uint64_t word = k / 64;
 	const uint64_t block = word >> LOG2_LONGWORDS_PER_ENTRY;
 	uint64_t c = counts[ block ];
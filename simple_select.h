@@ -24,7 +24,10 @@
 using namespace std;
 
 #include <stdint.h>
+#include <cstddef>
 #include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
 
 class simple_select {
 private:
@@ -36,12 +39,20 @@ private:
 		ones_per_inventory_mask, ones_per_sub16_mask, ones_per_sub64_mask;
 
 	uint64_t num_words, inventory_size, exact_spill_size, num_ones;
+	bool mapped;
+	sux_allocator *allocator;
 
 public:
 	simple_select();
-	simple_select( const uint64_t * const bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory );
+	simple_select( const uint64_t * const bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory, sux_allocator &allocator = default_allocator() );
 	~simple_select();
+	simple_select( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t select( const uint64_t rank );
+	/** Selects n ranks at once, writing the results into out. Queries go through a
+	 * three-stage pipeline (inventory, subinventory/spill, bit scan) so that the
+	 * memory accesses of different queries overlap. */
+	void select_batch( const uint64_t * const rank, const size_t n, uint64_t * const out );
 	// Just for analysis purposes
 	void print_counts();
 	uint64_t bit_count();
@@ -25,6 +25,8 @@ using namespace std;
 
 #include <stdint.h>
 #include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
 #include "select.h"
 
 class simple_select_half {
@@ -33,11 +35,17 @@ private:
 	int64_t *inventory;
 
 	uint64_t num_words, inventory_size, num_ones;
+	bool mapped;
+	sux_allocator *allocator;
 
 public:
 	simple_select_half();
-	simple_select_half( const uint64_t * const bits, const uint64_t num_bits );
+	simple_select_half( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator = default_allocator() );
+	/** Returns the number of bytes the structure allocates for a bit vector containing num_ones ones. */
+	static uint64_t allocation_size( const uint64_t num_ones );
 	~simple_select_half();
+	simple_select_half( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t select( const uint64_t rank );
 	uint64_t select( const uint64_t rank, uint64_t * const next );
 	// Just for analysis purposes
@@ -25,21 +25,25 @@ using namespace std;
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <vector>
+#include "popcount.h"
 #include "select.h"
 #include "simple_select_zero.h"
 #include "rank9.h"
+#include "inventory_builder.h"
 
 #define MAX_ONES_PER_INVENTORY (8192)
 
 simple_select_zero::simple_select_zero() {}
 
-simple_select_zero::simple_select_zero( const uint64_t * const bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory ) {
+simple_select_zero::simple_select_zero( const uint64_t * const bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
 	this->bits = bits;
 	num_words = ( num_bits + 63 ) / 64;
 	
 	// Init rank/select structure
-	uint64_t c = 0;
-	for( uint64_t i = 0; i < num_words; i++ ) c += __builtin_popcountll( ~bits[ i ] );
+	uint64_t c = num_words * 64 - count_ones( bits, num_words );
 	num_ones = c;
 
 if ( num_bits % 64 != 0 ) c -= 64 - num_bits % 64;
@@ -66,111 +70,62 @@ if ( num_bits % 64 != 0 ) c -= 64 - num_bits % 64;
 
 	printf("Longwords per subinventory: %d Ones per sub 64: %d sub 16: %d\n", longwords_per_subinventory, ones_per_sub64, ones_per_sub16 );
 
-	inventory = new int64_t[ inventory_size * longwords_per_inventory + 1 ];
+	inventory = (int64_t *)allocator.allocate( ( inventory_size * longwords_per_inventory + 1 ) * sizeof *inventory );
 	const int64_t *end_of_inventory = inventory + inventory_size * longwords_per_inventory + 1;
 
-	uint64_t d = 0;
-
-	// First phase: we build an inventory for each one out of ones_per_inventory.
-	for( uint64_t i = 0; i < num_words; i++ )
-		for( int j = 0; j < 64; j++ ) {
-			if ( i * 64 + j >= num_bits ) break;
-			if ( ~bits[ i ] & 1ULL << j ) {
-				if ( ( d & ones_per_inventory_mask ) == 0 ) inventory[ ( d >> log2_ones_per_inventory ) * longwords_per_inventory ] = i * 64 + j;
-				d++;
+	// Inventory, subinventories and exact spill are filled in a single pass, one inventory block at a time.
+	vector<uint64_t> spill;
+	uint64_t d = 0, exact = 0;
+
+	for_each_block<true>( bits, num_bits, log2_ones_per_inventory, [&]( const uint64_t inventory_index, const uint64_t * const pos, const uint64_t ones, const uint64_t end ) {
+		const uint64_t start = pos[ 0 ];
+		const uint64_t span = end - start;
+		int64_t * const p64 = &inventory[ inventory_index * longwords_per_inventory + 1 ];
+		uint16_t * const p16 = (uint16_t *)p64;
+		int offset = 0;
+
+		inventory[ inventory_index * longwords_per_inventory ] = start;
+		d += ones;
+		if ( ones_per_inventory == 1 ) return;
+
+		assert( end == num_bits || ones == ones_per_inventory );
+
+		if ( span < (1<<16) ) {
+			for( uint64_t k = 0; k < ones; k += ones_per_sub16 ) {
+				assert( pos[ k ] - start <= (1<<16) );
+				assert( offset < longwords_per_subinventory * 4 );
+				assert( p16 + offset < (uint16_t *)end_of_inventory );
+				p16[ offset++ ] = pos[ k ] - start;
+			}
+		}
+		else {
+			// We accumulate space for exact pointers ONLY if necessary.
+			exact += ones;
+			if ( ones_per_sub64 == 1 ) {
+				for( uint64_t k = 0; k < ones; k++ ) {
+					assert( p64 + offset < end_of_inventory );
+					p64[ offset++ ] = pos[ k ];
+				}
+			}
+			else {
+				assert( p64 < end_of_inventory );
+				inventory[ inventory_index * longwords_per_inventory ] |= 1ULL << 63;
+				p64[ 0 ] = spill.size();
+				spill.insert( spill.end(), pos, pos + ones );
 			}
 		}
+	} );
 
 	assert( c == d );
 	inventory[ inventory_size * longwords_per_inventory ] = num_bits;
 
 	printf("Inventory entries filled: %lld\n", inventory_size + 1 );
+	printf("Spilled entries: %lld exact: %lld\n", (uint64_t)spill.size(), exact );
 
-	if ( ones_per_inventory > 1 ) {
-		d = 0;
-		int ones;
-		uint64_t spilled = 0, exact = 0, start, span, inventory_index;
-
-		for( uint64_t i = 0; i < num_words; i++ )
-			// We estimate the subinventory and exact spill size
-			for( int j = 0; j < 64; j++ ) {
-				if ( i * 64 + j >= num_bits ) break;
-				if ( ~bits[ i ] & 1ULL << j ) {
-					if ( ( d & ones_per_inventory_mask ) == 0 ) {
-						inventory_index = d >> log2_ones_per_inventory;
-						start = inventory[ inventory_index * longwords_per_inventory ];
-						span = inventory[ ( inventory_index + 1 ) * longwords_per_inventory ] - start;
-						ones = min( c - d, (uint64_t)ones_per_inventory );
-						
-						assert( start + span == num_bits || ones == ones_per_inventory );
-
-						// We accumulate space for exact pointers ONLY if necessary.
-						if ( span >= (1<<16) ) {
-							exact += ones;
-							if ( ones_per_sub64 > 1 ) spilled += ones;
-						}
-
-					}
-					d++;
-				}
-			}
-
-		printf("Spilled entries: %lld exact: %lld\n", spilled, exact );
-
-		exact_spill_size = spilled;
-		exact_spill = new uint64_t[ exact_spill_size ];
-
-		uint16_t *p16;
-		int64_t *p64;
-		int offset;
-		spilled = 0;
-		d = 0;
-
-		for( uint64_t i = 0; i < num_words; i++ )
-			for( int j = 0; j < 64; j++ ) {
-				if ( i * 64 + j >= num_bits ) break;
-				if ( ~bits[ i ] & 1ULL << j ) {
-					if ( ( d & ones_per_inventory_mask ) == 0 ) {
-						inventory_index = d >> log2_ones_per_inventory;
-						start = inventory[ inventory_index * longwords_per_inventory ];
-						span = inventory[ ( inventory_index + 1 ) * longwords_per_inventory ] - start;
-						p64 = &inventory[ inventory_index * longwords_per_inventory + 1 ];
-						p16 = (uint16_t *)p64;
-						offset = 0;
-					}
-
-					if ( span < (1<<16) ) {
-						assert( i * 64 + j - start <= (1<<16) );
-						if ( ( d & ones_per_sub16_mask ) == 0 ) {
-							assert( offset < longwords_per_subinventory * 4 );
-							assert( p16 + offset < (uint16_t *)end_of_inventory );
-							p16[ offset++ ] = i * 64 + j - start;
-						}
-					}
-					else {
-						if ( ones_per_sub64 == 1 ) {
-							assert( p64 + offset < end_of_inventory );
-							p64[ offset++ ] = i * 64 + j;
-						}
-						else {
-							assert( p64 < end_of_inventory );
-							if ( ( d & ones_per_inventory_mask ) == 0 ) {
-								inventory[ inventory_index * longwords_per_inventory ] |= 1ULL << 63;
-								p64[ 0 ] = spilled;
-							}
-							assert( spilled < exact_spill_size );
-							exact_spill[ spilled++ ] = i * 64 + j;
-						}
-					}
-
-					d++;
-				}
-			}
-	}
-	else {
-		exact_spill = NULL;
-		exact_spill_size = 0;
-	}
+	exact_spill_size = spill.size();
+	// The size of the spill is known only now, so it cannot share the arena of the inventory.
+	exact_spill = exact_spill_size == 0 ? NULL : (uint64_t *)allocator.allocate( exact_spill_size * sizeof *exact_spill );
+	copy( spill.begin(), spill.end(), exact_spill );
 
 #ifdef DEBUG
 	printf("First inventories: %lld %lld %lld %lld\n", inventory[ 0 ], inventory[ 1 ], inventory[ 2 ], inventory[ 3 ] );
@@ -207,11 +162,59 @@ if ( num_bits % 64 != 0 ) c -= 64 - num_bits % 64;
 }
 
 simple_select_zero::~simple_select_zero() {
-	delete [] inventory;
-	delete [] exact_spill;
+	if ( ! mapped ) {
+		allocator->deallocate( inventory, ( inventory_size * longwords_per_inventory + 1 ) * sizeof *inventory );
+		if ( exact_spill != NULL ) allocator->deallocate( exact_spill, exact_spill_size * sizeof *exact_spill );
+	}
+}
+
+simple_select_zero::simple_select_zero( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "simple_select_zero" );
+	num_words = reader.scalar();
+	num_ones = reader.scalar();
+	inventory_size = reader.scalar();
+	exact_spill_size = reader.scalar();
+	log2_ones_per_inventory = reader.scalar();
+	log2_ones_per_sub16 = reader.scalar();
+	log2_ones_per_sub64 = reader.scalar();
+	log2_longwords_per_subinventory = reader.scalar();
+	ones_per_inventory = reader.scalar();
+	ones_per_sub16 = reader.scalar();
+	ones_per_sub64 = reader.scalar();
+	longwords_per_subinventory = reader.scalar();
+	longwords_per_inventory = reader.scalar();
+	ones_per_inventory_mask = reader.scalar();
+	ones_per_sub16_mask = reader.scalar();
+	ones_per_sub64_mask = reader.scalar();
+	inventory = reader.array<int64_t>( inventory_size * longwords_per_inventory + 1 );
+	exact_spill = reader.array<uint64_t>( exact_spill_size );
+}
+
+void simple_select_zero::save( sux_writer &writer ) {
+	writer.header( "simple_select_zero" );
+	writer.scalar( num_words );
+	writer.scalar( num_ones );
+	writer.scalar( inventory_size );
+	writer.scalar( exact_spill_size );
+	writer.scalar( log2_ones_per_inventory );
+	writer.scalar( log2_ones_per_sub16 );
+	writer.scalar( log2_ones_per_sub64 );
+	writer.scalar( log2_longwords_per_subinventory );
+	writer.scalar( ones_per_inventory );
+	writer.scalar( ones_per_sub16 );
+	writer.scalar( ones_per_sub64 );
+	writer.scalar( longwords_per_subinventory );
+	writer.scalar( longwords_per_inventory );
+	writer.scalar( ones_per_inventory_mask );
+	writer.scalar( ones_per_sub16_mask );
+	writer.scalar( ones_per_sub64_mask );
+	writer.array( inventory, inventory_size * longwords_per_inventory + 1 );
+	writer.array( exact_spill, exact_spill_size );
 }
 
-uint64_t simple_select_zero::select_zero( const uint64_t rank ) {
+MULTIVERSION uint64_t simple_select_zero::select_zero( const uint64_t rank ) {
 #ifdef DEBUG
 	printf( "Selecting %lld\n...", rank );
 #endif
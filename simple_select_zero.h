@@ -25,6 +25,8 @@ using namespace std;
 
 #include <stdint.h>
 #include "macros.h"
+#include "serialize.h"
+#include "allocator.h"
 
 class simple_select_zero {
 private:
@@ -36,11 +38,15 @@ private:
 		ones_per_inventory_mask, ones_per_sub16_mask, ones_per_sub64_mask;
 
 	uint64_t num_words, inventory_size, exact_spill_size, num_ones;
+	bool mapped;
+	sux_allocator *allocator;
 
 public:
 	simple_select_zero();
-	simple_select_zero( const uint64_t * const bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory );
+	simple_select_zero( const uint64_t * const bits, const uint64_t num_bits, const int max_log2_longwords_per_subinventory, sux_allocator &allocator = default_allocator() );
 	~simple_select_zero();
+	simple_select_zero( const uint64_t * const bits, sux_reader &reader );
+	void save( sux_writer &writer );
 	uint64_t select_zero( const uint64_t rank );
 	// Just for analysis purposes
 	void print_counts();
@@ -25,8 +25,10 @@ using namespace std;
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include "popcount.h"
 #include "simple_select_zero_half.h"
 #include "rank9.h"
+#include "inventory_builder.h"
 
 #define LOG2_ONES_PER_INVENTORY (10)
 #define ONES_PER_INVENTORY (1 << LOG2_ONES_PER_INVENTORY)
@@ -43,13 +45,18 @@ using namespace std;
 
 simple_select_zero_half::simple_select_zero_half() {}
 
-simple_select_zero_half::simple_select_zero_half( const uint64_t * const bits, const uint64_t num_bits ) {
+uint64_t simple_select_zero_half::allocation_size( const uint64_t num_zeroes ) {
+	return ( ( num_zeroes + ONES_PER_INVENTORY - 1 ) / ONES_PER_INVENTORY * (LONGWORDS_PER_SUBINVENTORY + 1) + 1 ) * sizeof(int64_t);
+}
+
+simple_select_zero_half::simple_select_zero_half( const uint64_t * const bits, const uint64_t num_bits, sux_allocator &allocator ) {
+	mapped = false;
+	this->allocator = &allocator;
 	this->bits = bits;
 	num_words = ( num_bits + 63 ) / 64;
 	
 	// Init rank/select structure
-	uint64_t c = 0;
-	for( uint64_t i = 0; i < num_words; i++ ) c += __builtin_popcountll( ~bits[ i ] );
+	uint64_t c = num_words * 64 - count_ones( bits, num_words );
 	num_ones = c;
 
 if ( num_bits % 64 != 0 ) c -= 64 - num_bits % 64;
@@ -61,68 +68,42 @@ if ( num_bits % 64 != 0 ) c -= 64 - num_bits % 64;
 
 	printf("Ones per inventory: %d Ones per sub 64: %d sub 16: %d\n", ONES_PER_INVENTORY, ONES_PER_SUB64, ONES_PER_SUB16 );	
 
-	inventory = new int64_t[ inventory_size * (LONGWORDS_PER_SUBINVENTORY + 1) + 1 ];
-	const int64_t *end_of_inventory = inventory + inventory_size * (LONGWORDS_PER_SUBINVENTORY + 1) + 1;
+	inventory = (int64_t *)allocator.allocate( allocation_size( c ) );
+
+	// Inventory and subinventories are filled in a single pass, one inventory block at a time.
+	uint64_t d = 0, exact = 0;
+
+	for_each_block<true>( bits, num_bits, LOG2_ONES_PER_INVENTORY, [&]( const uint64_t inventory_index, const uint64_t * const pos, const uint64_t ones, const uint64_t end ) {
+		const uint64_t start = pos[ 0 ];
+		const uint64_t span = end - start;
+		int64_t * const p64 = &inventory[ inventory_index * (LONGWORDS_PER_SUBINVENTORY + 1) + 1 ];
+		uint16_t * const p16 = (uint16_t *)p64;
+		int offset = 0;
 
-	uint64_t d = 0;
-	const uint64_t mask = ONES_PER_INVENTORY - 1;
+		// Offsets are smaller than the span, so up to 2^16 they fit into 16 bits.
+		inventory[ inventory_index * (LONGWORDS_PER_SUBINVENTORY + 1) ] = span > (1<<16) ? -start - 1 : start;
+		d += ones;
 
-	// First phase: we build an inventory for each one out of ONES_PER_INVENTORY.
-	for( uint64_t i = 0; i < num_words; i++ )
-		for( int j = 0; j < 64; j++ ) {
-			if ( i * 64 + j >= num_bits ) break;
-			if ( ~bits[ i ] & 1ULL << j ) {
-				if ( ( d & mask ) == 0 ) inventory[ (d >> LOG2_ONES_PER_INVENTORY) * (LONGWORDS_PER_SUBINVENTORY + 1) ] = i * 64 + j;
-				d++;
+		if ( span <= (1<<16) ) {
+			for( uint64_t k = 0; k < ones; k += ONES_PER_SUB16 ) {
+				assert( pos[ k ] - start < (1<<16) );
+				assert( offset < LONGWORDS_PER_SUBINVENTORY * 4 );
+				p16[ offset++ ] = pos[ k ] - start;
 			}
 		}
+		else {
+			for( uint64_t k = 0; k < ones; k += ONES_PER_SUB64 ) {
+				assert( offset < LONGWORDS_PER_SUBINVENTORY );
+				p64[ offset++ ] = pos[ k ] - start;
+				exact++;
+			}
+		}
+	} );
 
 	assert( c == d );
 	inventory[ inventory_size * (LONGWORDS_PER_SUBINVENTORY + 1) ] = num_bits;
 
 	printf("Inventory entries filled: %lld\n", inventory_size + 1 );
-
-
-	uint16_t *p16;
-	int64_t *p64;
-
-	d = 0;
-	uint64_t exact = 0, start, span, inventory_index;
-	int offset;
-
-	for( uint64_t i = 0; i < num_words; i++ )
-		for( int j = 0; j < 64; j++ ) {
-			if ( i * 64 + j >= num_bits ) break;
-			if ( ~bits[ i ] & 1ULL << j ) {
-				if ( ( d & mask ) == 0 ) {
-					inventory_index = (d >> LOG2_ONES_PER_INVENTORY) * (LONGWORDS_PER_SUBINVENTORY + 1);
-					start = inventory[ inventory_index ];
-					span = inventory[ inventory_index + LONGWORDS_PER_SUBINVENTORY + 1 ] - start;
-					if ( span > (1<<16) ) inventory[ inventory_index ] = -inventory[ inventory_index ] - 1;
-					offset = 0;
-					p64 = &inventory[ inventory_index + 1 ];
-					p16 = (uint16_t *)p64;
-				}
-
-				if ( span < (1<<16) ) {
-					assert( i * 64 + j - start <= (1<<16) );
-					if ( ( d & ONES_PER_SUB16_MASK ) == 0 ) {
-						assert( offset < LONGWORDS_PER_SUBINVENTORY * 4 );
-						p16[ offset++ ] = i * 64 + j - start;
-					}
-				}
-				else {
-					if ( ( d & ONES_PER_SUB64_MASK ) == 0 ) {
-						assert( offset < LONGWORDS_PER_SUBINVENTORY );
-						p64[ offset++ ] = i * 64 + j - start;
-						exact++;
-					}
-				}
-
-				d++;
-			}
-		}
-
 	printf("Exact entries: %lld\n", exact );
 
 #ifdef DEBUG
@@ -158,10 +139,28 @@ if ( num_bits % 64 != 0 ) c -= 64 - num_bits % 64;
 }
 
 simple_select_zero_half::~simple_select_zero_half() {
-	delete [] inventory;
+	if ( ! mapped ) allocator->deallocate( inventory, ( inventory_size * (LONGWORDS_PER_SUBINVENTORY + 1) + 1 ) * sizeof *inventory );
+}
+
+simple_select_zero_half::simple_select_zero_half( const uint64_t * const bits, sux_reader &reader ) {
+	this->bits = bits;
+	mapped = true;
+	reader.header( "simple_select_zero_half" );
+	num_words = reader.scalar();
+	num_ones = reader.scalar();
+	inventory_size = reader.scalar();
+	inventory = reader.array<int64_t>( inventory_size * (LONGWORDS_PER_SUBINVENTORY + 1) + 1 );
+}
+
+void simple_select_zero_half::save( sux_writer &writer ) {
+	writer.header( "simple_select_zero_half" );
+	writer.scalar( num_words );
+	writer.scalar( num_ones );
+	writer.scalar( inventory_size );
+	writer.array( inventory, inventory_size * (LONGWORDS_PER_SUBINVENTORY + 1) + 1 );
 }
 
-uint64_t simple_select_zero_half::select_zero( const uint64_t rank ) {
+MULTIVERSION uint64_t simple_select_zero_half::select_zero( const uint64_t rank ) {
 #ifdef DEBUG
 	printf( "Selecting %lld\n...", rank );
 #endif
@@ -211,7 +210,7 @@ uint64_t simple_select_zero_half::select_zero( const uint64_t rank ) {
 	return word_index * 64 + select_in_word( word, residual );
 }
 
-uint64_t simple_select_zero_half::select_zero( const uint64_t rank, uint64_t * const next ) {
+MULTIVERSION uint64_t simple_select_zero_half::select_zero( const uint64_t rank, uint64_t * const next ) {
 	const uint64_t s = select_zero( rank );
 	int curr = s / 64;
 
@@ -0,0 +1,154 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+using namespace std;
+
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <thread>
+#include "appendable_rank9.h"
+#include "rank9.h"
+#include "posrep.h"
+
+static uint64_t s[ 16 ] = {
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL
+};
+
+static uint64_t __inline xrand(void) {
+    static int p;
+    uint64_t s0 = s[ p ];
+    uint64_t s1 = s[ p = ( p + 1 ) & 15 ];
+    s1 ^= s1 << 31; // a
+    s1 ^= s1 >> 11; // b
+    s0 ^= s0 >> 30; // c
+    return ( s[ p ] = s0 ^ s1 ) * 1181783497276652981LL;
+}
+
+// Wall-clock time, as the concurrent phase runs two threads
+uint64_t getusertime() {
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+int main( int argc, char *argv[] ) {
+	if ( argc < 2 ) {
+		fprintf( stderr, "Usage: %s NUMBITS [DENSITY [BATCH]]\n", argv[ 0 ] );
+		return 0;
+	}
+
+	const uint64_t num_words = strtoll( argv[ 1 ], NULL, 0 ) / 64;
+	const double density = argc > 2 ? atof( argv[ 2 ] ) : .5;
+	const uint64_t batch = argc > 3 ? strtoll( argv[ 3 ], NULL, 0 ) : 1024;
+	assert( num_words != 0 );
+	assert( density >= 0 && density < 1 );
+	assert( batch != 0 );
+	const uint64_t threshold = (uint64_t)( UINT64_MAX * density );
+
+	uint64_t * const bits = new uint64_t[ num_words + 1 ]();
+	for( uint64_t i = 0; i < num_words * 64; i++ ) if ( xrand() < threshold ) bits[ i / 64 ] |= 1ULL << i % 64;
+
+	uint64_t start, elapsed, dummy = 0;
+
+	// Appending word by word and in batches
+	start = getusertime();
+	{
+		appendable_rank9 ar( num_words * 64 );
+		for( uint64_t i = 0; i < num_words; i++ ) ar.push_back( bits[ i ] );
+		dummy ^= ar.rank( ar.size() );
+	}
+	elapsed = getusertime() - start;
+	printf( "push_back: %f ns/word\n", elapsed * 1E3 / num_words );
+
+	start = getusertime();
+	{
+		appendable_rank9 ar( num_words * 64 );
+		for( uint64_t i = 0; i < num_words; i += batch ) ar.append( bits + i, min( batch, num_words - i ) );
+		dummy ^= ar.rank( ar.size() );
+	}
+	elapsed = getusertime() - start;
+	printf( "append (batches of %lld words): %f ns/word\n", (long long)batch, elapsed * 1E3 / num_words );
+
+	// For comparison, rebuilding a rank9 after each of (at most) 100 batches
+	const uint64_t step = max( batch, num_words / 100 );
+	start = getusertime();
+	for( uint64_t i = step; i < num_words + step; i += step ) {
+		rank9 r( bits, min( i, num_words ) * 64 );
+		dummy ^= r.rank( min( i, num_words ) * 64 );
+	}
+	elapsed = getusertime() - start;
+	printf( "rebuilding rank9 every %lld words: %f ns/word\n", (long long)step, elapsed * 1E3 / num_words );
+
+	// Concurrent phase: a writer appends in batches while a reader queries the published prefix
+	appendable_rank9 ar( num_words * 64 );
+	uint64_t checked = 0;
+	thread writer( [ & ] {
+		for( uint64_t i = 0; i < num_words; i += batch ) {
+			ar.append( bits + i, min( batch, num_words - i ) );
+			this_thread::yield(); // Let the reader in, even on a single core
+		}
+	} );
+	thread reader( [ & ] {
+		uint64_t r = 1;
+		for( uint64_t size; ( size = ar.size() ) < num_words * 64; ) {
+			if ( size == 0 ) continue;
+			r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+			const uint64_t p = ( r >> 11 ) % size & ~63;
+			// Every word in the prefix must be ranked consistently with its content
+			if ( ar.rank( p + 64 ) - ar.rank( p ) != (uint64_t)__builtin_popcountll( bits[ p / 64 ] ) ) {
+				fprintf( stderr, "Inconsistent rank at %lld (size %lld)\n", (long long)p, (long long)size );
+				abort();
+			}
+			checked++;
+		}
+	} );
+	writer.join();
+	reader.join();
+	printf( "Checked %lld concurrent queries\n", (long long)checked );
+
+	uint64_t * const position = new uint64_t[ POSITIONS ];
+	for( int i = 0; i < POSITIONS; i++ ) position[ i ] = xrand() % ( num_words * 64 + 1 );
+
+	start = getusertime();
+	for( int k = REPEATS; k-- != 0; ) for( int i = 0; i < POSITIONS; i++ ) dummy ^= ar.rank( position[ i ] );
+	elapsed = getusertime() - start;
+	printf( "rank: %f ns/rank\n", elapsed * 1E3 / ( REPEATS * POSITIONS ) );
+
+#ifndef NDEBUG
+	rank9 r( bits, num_words * 64 );
+	for( uint64_t i = 0; i <= num_words * 64; i++ ) {
+		assert( ar.rank( i ) == r.rank( i ) );
+		if ( i < num_words * 64 ) assert( ar.get( i ) == ( bits[ i / 64 ] >> i % 64 & 1 ) );
+	}
+#endif
+
+	delete [] bits;
+	delete [] position;
+	if ( !dummy ) putchar(0); // To avoid excision
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+using namespace std;
+
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <vector>
+#include "dynamic_bit_vector.h"
+#include "rank9sel.h"
+#include "posrep.h"
+
+static uint64_t s[ 16 ] = {
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL
+};
+
+static uint64_t __inline xrand(void) {
+    static int p;
+    uint64_t s0 = s[ p ];
+    uint64_t s1 = s[ p = ( p + 1 ) & 15 ];
+    s1 ^= s1 << 31; // a
+    s1 ^= s1 >> 11; // b
+    s0 ^= s0 >> 30; // c
+    return ( s[ p ] = s0 ^ s1 ) * 1181783497276652981LL;
+}
+
+uint64_t getusertime() {
+	struct rusage rusage;
+	getrusage( 0, &rusage );
+	return rusage.ru_utime.tv_sec * 1000000ULL + rusage.ru_utime.tv_usec;
+}
+
+#define TIME( name, what ) \
+	start = getusertime(); \
+	for( int k = REPEATS; k-- != 0; ) for( int i = 0; i < POSITIONS; i++ ) what; \
+	elapsed = getusertime() - start; \
+	s = elapsed / 1E6; \
+	printf( "%-36s %f ns/operation\n", name, 1E9 * s / (REPEATS * POSITIONS) );
+
+int main( int argc, char *argv[] ) {
+	if ( argc < 2 ) {
+		fprintf( stderr, "Usage: %s NUMBITS [DENSITY]\n", argv[ 0 ] );
+		return 0;
+	}
+
+	const uint64_t num_bits = strtoll( argv[ 1 ], NULL, 0 );
+	const double density = argc > 2 ? atof( argv[ 2 ] ) : .5;
+	assert( num_bits != 0 );
+	assert( density > 0 && density <= 1 );
+	const uint64_t threshold = (uint64_t)( UINT64_MAX * density );
+
+	uint64_t * const bits = new uint64_t[ num_bits / 64 + 1 ]();
+	for( uint64_t i = 0; i < num_bits; i++ ) if ( xrand() < threshold ) bits[ i / 64 ] |= 1ULL << i % 64;
+
+	int64_t start, elapsed;
+	double s;
+
+	start = getusertime();
+	dynamic_bit_vector dbv( bits, num_bits );
+	printf( "Built in %f s; bit cost: %lld (%.2f%%)\n", ( getusertime() - start ) / 1E6, dbv.bit_count(), dbv.bit_count() * 100.0 / num_bits );
+
+	start = getusertime();
+	{
+		rank9sel rebuild( bits, num_bits );
+	}
+	printf( "For comparison, building rank9sel takes %f s\n", ( getusertime() - start ) / 1E6 );
+
+	const uint64_t num_ones = dbv.count();
+	assert( num_ones != 0 );
+	uint64_t * const position = new uint64_t[ POSITIONS ], * const rank = new uint64_t[ POSITIONS ];
+	for( int i = 0; i < POSITIONS; i++ ) {
+		position[ i ] = xrand() % num_bits;
+		rank[ i ] = xrand() % num_ones;
+	}
+
+	uint64_t dummy = 0;
+
+	TIME( "rank", dummy ^= dbv.rank( position[ i ] ) );
+	TIME( "select", dummy ^= dbv.select( rank[ i ] ) );
+	TIME( "get", dummy ^= dbv.get( position[ i ] ) );
+	// Every set is undone by a later one, as each position is visited twice per repetition
+	TIME( "set", dummy ^= dbv.set( position[ i ], ! dbv.get( position[ i ] ) ) );
+	// Insertions and deletions alternate, so that the size is unchanged
+	TIME( "insert/erase", if ( i & 1 ) dummy ^= dbv.erase( position[ i ] ); else dbv.insert( position[ i ], dummy & 1 ) );
+
+#ifndef NDEBUG
+	// Random operations, checked against a plain vector
+	vector<bool> check( num_bits );
+	for( uint64_t i = 0; i < num_bits; i++ ) check[ i ] = dbv.get( i );
+	uint64_t ones = dbv.count();
+
+	for( int i = 0; i < 200000; i++ ) {
+		const uint64_t p = xrand() % ( check.size() + 1 );
+		const bool value = xrand() & 1;
+
+		switch( xrand() % 6 ) {
+		case 0:
+			dbv.insert( p, value );
+			check.insert( check.begin() + p, value );
+			ones += value;
+			break;
+		case 1:
+			if ( p == check.size() ) break;
+			assert( dbv.erase( p ) == check[ p ] );
+			ones -= check[ p ];
+			check.erase( check.begin() + p );
+			break;
+		case 2:
+			if ( p == check.size() ) break;
+			assert( dbv.set( p, value ) == check[ p ] );
+			ones += (int)value - (int)check[ p ];
+			check[ p ] = value;
+			break;
+		default:
+			if ( p < check.size() ) assert( dbv.get( p ) == check[ p ] );
+			if ( ones != 0 ) {
+				const uint64_t k = p % ones, q = dbv.select( k );
+				assert( check[ q ] && dbv.rank( q ) == k );
+			}
+		}
+
+		assert( dbv.size() == check.size() );
+		assert( dbv.count() == ones );
+	}
+
+	// Full check, and then erase everything
+	uint64_t r = 0;
+	for( uint64_t i = 0; i < check.size(); i++ ) {
+		assert( dbv.rank( i ) == r );
+		if ( check[ i ] ) assert( dbv.select( r++ ) == i );
+	}
+	assert( dbv.rank( check.size() ) == r );
+
+	while( dbv.size() != 0 ) dbv.erase( xrand() % dbv.size() );
+	assert( dbv.count() == 0 );
+#endif
+
+	delete [] bits;
+	delete [] position;
+	delete [] rank;
+	if ( !dummy ) putchar(0); // To avoid excision
+
+	return 0;
+}
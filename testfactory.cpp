@@ -0,0 +1,173 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+using namespace std;
+
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include "rank_select_factory.h"
+#include "rank9sel.h"
+#include "posrep.h"
+
+static uint64_t s[ 16 ] = {
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL
+};
+
+static uint64_t __inline xrand(void) {
+    static int p;
+    uint64_t s0 = s[ p ];
+    uint64_t s1 = s[ p = ( p + 1 ) & 15 ];
+    s1 ^= s1 << 31; // a
+    s1 ^= s1 >> 11; // b
+    s0 ^= s0 >> 30; // c
+    return ( s[ p ] = s0 ^ s1 ) * 1181783497276652981LL;
+}
+
+uint64_t getusertime() {
+	struct rusage rusage;
+	getrusage( 0, &rusage );
+	return rusage.ru_utime.tv_sec * 1000000ULL + rusage.ru_utime.tv_usec;
+}
+
+// Checks a structure against rank9sel on random queries (on all positions, for short vectors). As in
+// testranksel, positions are smaller than num_bits, since not all structures support rank( num_bits ).
+static void check( rank_select &rs, rank_select_choice &choice, rank9sel &reference, const uint64_t num_bits, const uint64_t num_ones ) {
+	const bool all = num_bits <= 100000;
+	for( uint64_t i = 0; i < ( all ? num_bits : 1000000 ); i++ ) {
+		const uint64_t p = all ? i : xrand() % num_bits;
+		if ( choice.has_rank ) assert( rs.rank( p ) == reference.rank( p ) );
+		if ( choice.has_select && p < num_ones ) assert( rs.select( p ) == reference.select( p ) );
+	}
+}
+
+int main( int argc, char *argv[] ) {
+	if ( argc < 5 ) {
+		fprintf( stderr, "Usage: %s NUMBITS DENSITY0 DENSITY1 RANKFRACTION [MAXBITSPERBIT]\n", argv[ 0 ] );
+		return 0;
+	}
+
+	const uint64_t num_bits = strtoll( argv[ 1 ], NULL, 0 );
+	const double density0 = atof( argv[ 2 ] ), density1 = atof( argv[ 3 ] ), rank_fraction = atof( argv[ 4 ] );
+	const uint64_t max_bits = argc > 5 ? (uint64_t)( atof( argv[ 5 ] ) * num_bits ) : UINT64_MAX;
+	assert( num_bits != 0 );
+	assert( density0 >= 0 && density0 < 1 && density1 >= 0 && density1 < 1 );
+	assert( rank_fraction >= 0 && rank_fraction <= 1 );
+	const uint64_t threshold0 = (uint64_t)( UINT64_MAX * density0 ), threshold1 = (uint64_t)( UINT64_MAX * density1 );
+
+	// As in testranksel, the density changes halfway, and with -DRUNS=L bits come in runs of about L bits.
+	uint64_t * const bits = new uint64_t[ num_bits / 64 + 1 ]();
+	uint64_t num_ones = 0;
+	bool bit = false;
+	for( uint64_t i = 0; i < num_bits; i++ ) {
+		const uint64_t threshold = i < num_bits / 2 ? threshold0 : threshold1;
+#ifdef RUNS
+		if ( xrand() % RUNS == 0 ) bit = xrand() < threshold;
+#else
+		bit = xrand() < threshold;
+#endif
+		if ( bit ) {
+			num_ones++;
+			bits[ i / 64 ] |= 1ULL << i % 64;
+		}
+	}
+
+	int64_t start, elapsed;
+	double s;
+
+	start = getusertime();
+	bit_vector_profile profile( bits, num_bits );
+	printf( "Profiled in %f s\n", ( getusertime() - start ) / 1E6 );
+	profile.print();
+	assert( profile.num_ones == num_ones );
+
+	rank_select_choice candidates[ rank_select_choice::NUM_TYPES + 3 ];
+	const int num_candidates = rank_select_candidates( profile, rank_fraction, candidates );
+	printf( "Candidates for %.0f%% ranks (space includes the bit vector when needed):\n", rank_fraction * 100 );
+	for( int i = 0; i < num_candidates; i++ ) candidates[ i ].print( num_bits, rank_fraction );
+
+	rank_select_choice choice = choose_rank_select( profile, rank_fraction, max_bits );
+	printf( "Chosen%s: ", choice.predicted_bits > max_bits ? " (over budget)" : "" );
+	choice.print( num_bits, rank_fraction );
+
+	rank_select * const rs = build_rank_select( choice, bits, num_bits );
+	const uint64_t actual_bits = rs->bit_count() + ( choice.needs_bits ? num_bits : 0 );
+	printf( "Actual space: %lld (%.2f%%), predicted %lld\n", actual_bits, actual_bits * 100.0 / num_bits, choice.predicted_bits );
+
+	// Positions for ranks, and ranks for selects
+	uint64_t * const query = new uint64_t[ POSITIONS ];
+	const uint64_t rank_threshold = (uint64_t)( UINT64_MAX * rank_fraction );
+	for( int i = 0; i < POSITIONS; i++ ) {
+		const bool is_rank = rank_fraction == 1 || num_ones == 0 || rank_fraction != 0 && xrand() <= rank_threshold;
+		query[ i ] = is_rank ? xrand() % num_bits : 1ULL << 63 | xrand() % max( num_ones, (uint64_t)1 );
+	}
+
+	uint64_t dummy = 0;
+	start = getusertime();
+	for( int k = REPEATS; k-- != 0; )
+		for( int i = 0; i < POSITIONS; i++ )
+			dummy ^= query[ i ] >> 63 ? rs->select( query[ i ] & ~( 1ULL << 63 ) ) : rs->rank( query[ i ] );
+	elapsed = getusertime() - start;
+	s = elapsed / 1E6;
+	printf( "Actual mix: %f ns/query, predicted %f ns/query\n", 1E9 * s / ( REPEATS * POSITIONS ), choice.predicted_ns( rank_fraction ) );
+
+#ifndef NDEBUG
+	// Every candidate answers correctly and has the predicted space (simple_select might spill more).
+	rank9sel reference( bits, num_bits );
+	for( int i = 0; i < num_candidates; i++ ) {
+		rank_select * const c = build_rank_select( candidates[ i ], bits, num_bits );
+		const uint64_t actual = c->bit_count() + ( candidates[ i ].needs_bits ? num_bits : 0 );
+		if ( candidates[ i ].type == rank_select_choice::SIMPLE_SELECT ) assert( candidates[ i ].predicted_bits <= actual );
+		else assert( candidates[ i ].predicted_bits == actual );
+		check( *c, candidates[ i ], reference, num_bits, num_ones );
+		delete c;
+	}
+
+	// A prefix ending with a partial chunk made of whole 512-bit blocks, a corner case of hybrid_bit_vector
+	const uint64_t prefix_bits = 65536 + 1024;
+	if ( num_bits > prefix_bits ) {
+		uint64_t * const prefix = new uint64_t[ prefix_bits / 64 + 1 ]();
+		copy( bits, bits + prefix_bits / 64, prefix );
+		uint64_t prefix_ones = 0;
+		for( uint64_t i = 0; i < prefix_bits / 64; i++ ) prefix_ones += __builtin_popcountll( prefix[ i ] );
+		rank9sel prefix_reference( prefix, prefix_bits );
+		for( int i = 0; i < num_candidates; i++ ) {
+			rank_select * const c = build_rank_select( candidates[ i ], prefix, prefix_bits );
+			check( *c, candidates[ i ], prefix_reference, prefix_bits, prefix_ones );
+			delete c;
+		}
+		delete [] prefix;
+	}
+#endif
+
+	delete rs;
+	delete [] bits;
+	delete [] query;
+	if ( !dummy ) putchar(0); // To avoid excision
+
+	return 0;
+}
@@ -0,0 +1,135 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+using namespace std;
+
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include "fenwick_rank9.h"
+#include "rank9.h"
+#include "posrep.h"
+
+static uint64_t s[ 16 ] = {
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL
+};
+
+static uint64_t __inline xrand(void) {
+    static int p;
+    uint64_t s0 = s[ p ];
+    uint64_t s1 = s[ p = ( p + 1 ) & 15 ];
+    s1 ^= s1 << 31; // a
+    s1 ^= s1 >> 11; // b
+    s0 ^= s0 >> 30; // c
+    return ( s[ p ] = s0 ^ s1 ) * 1181783497276652981LL;
+}
+
+uint64_t getusertime() {
+	struct rusage rusage;
+	getrusage( 0, &rusage );
+	return rusage.ru_utime.tv_sec * 1000000ULL + rusage.ru_utime.tv_usec;
+}
+
+#define TIME( name, what ) \
+	start = getusertime(); \
+	for( int k = REPEATS; k-- != 0; ) for( int i = 0; i < POSITIONS; i++ ) what; \
+	elapsed = getusertime() - start; \
+	s = elapsed / 1E6; \
+	printf( "%-36s %f ns/operation\n", name, 1E9 * s / (REPEATS * POSITIONS) );
+
+int main( int argc, char *argv[] ) {
+	if ( argc < 2 ) {
+		fprintf( stderr, "Usage: %s NUMBITS [DENSITY]\n", argv[ 0 ] );
+		return 0;
+	}
+
+	const uint64_t num_bits = strtoll( argv[ 1 ], NULL, 0 );
+	const double density = argc > 2 ? atof( argv[ 2 ] ) : .5;
+	assert( num_bits != 0 );
+	assert( density >= 0 && density < 1 );
+	const uint64_t threshold = (uint64_t)( UINT64_MAX * density );
+
+	uint64_t * const bits = new uint64_t[ num_bits / 64 + 1 ]();
+	for( uint64_t i = 0; i < num_bits; i++ ) if ( xrand() < threshold ) bits[ i / 64 ] |= 1ULL << i % 64;
+
+	int64_t start, elapsed;
+	double s;
+
+	start = getusertime();
+	fenwick_rank9 fr( bits, num_bits );
+	printf( "Built in %f s; bit cost: %lld (%.2f%%)\n", ( getusertime() - start ) / 1E6, fr.bit_count(), fr.bit_count() * 100.0 / num_bits );
+
+	start = getusertime();
+	rank9 r( bits, num_bits );
+	printf( "For comparison, building rank9 takes %f s; bit cost: %lld (%.2f%%)\n", ( getusertime() - start ) / 1E6, r.bit_count(), r.bit_count() * 100.0 / num_bits );
+
+	uint64_t * const position = new uint64_t[ POSITIONS ];
+	// The top bit of each position tells whether the operation is an update
+	uint64_t * const op = new uint64_t[ POSITIONS ];
+	for( int i = 0; i < POSITIONS; i++ ) position[ i ] = xrand() % num_bits;
+
+	uint64_t dummy = 0;
+
+	TIME( "rank9 rank", dummy ^= r.rank( position[ i ] ) );
+	TIME( "rank", dummy ^= fr.rank( position[ i ] ) );
+	// Every set is undone by a later one, as each position is visited twice per repetition
+	TIME( "set", dummy ^= fr.set( position[ i ], ! fr.get( position[ i ] ) ) );
+
+	// Mixed workloads: a fraction of the operations flips a bit, the others are ranks
+	const double ratio[] = { .01, .1, .5, .9 };
+	for( size_t t = 0; t < sizeof ratio / sizeof *ratio; t++ ) {
+		const uint64_t update_threshold = (uint64_t)( UINT64_MAX * ratio[ t ] );
+		for( int i = 0; i < POSITIONS; i++ ) op[ i ] = position[ i ] | ( xrand() < update_threshold ? 1ULL << 63 : 0 );
+		char name[ 64 ];
+		sprintf( name, "%d%% updates", (int)( ratio[ t ] * 100 ) );
+		TIME( name, if ( op[ i ] >> 63 ) dummy ^= fr.set( op[ i ] & ~( 1ULL << 63 ), ! fr.get( op[ i ] & ~( 1ULL << 63 ) ) ); else dummy ^= fr.rank( op[ i ] ) );
+	}
+
+#ifndef NDEBUG
+	// Random updates, checking locally that counts are consistent with the bits
+	for( int i = 0; i < 1000000; i++ ) {
+		const uint64_t p = xrand() % num_bits;
+		const bool value = xrand() & 1, old = fr.get( p );
+		assert( fr.set( p, value ) == old );
+		assert( fr.get( p ) == value );
+		const uint64_t q = p & ~63;
+		assert( fr.rank( min( q + 64, num_bits ) ) - fr.rank( q ) == (uint64_t)__builtin_popcountll( bits[ q / 64 ] ) );
+	}
+
+	// Full check against a rank9 on the modified bits
+	rank9 check( bits, num_bits );
+	for( uint64_t i = 0; i <= num_bits; i++ ) assert( fr.rank( i ) == check.rank( i ) );
+	assert( fr.count() == check.rank( num_bits ) );
+#endif
+
+	delete [] bits;
+	delete [] position;
+	delete [] op;
+	if ( !dummy ) putchar(0); // To avoid excision
+
+	return 0;
+}
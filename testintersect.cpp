@@ -0,0 +1,155 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+using namespace std;
+
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include "elias_fano.h"
+#include "posting_lists.h"
+
+static uint64_t s[ 16 ] = {
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL
+};
+
+static uint64_t __inline xrand(void) {
+    static int p;
+    uint64_t s0 = s[ p ];
+    uint64_t s1 = s[ p = ( p + 1 ) & 15 ];
+    s1 ^= s1 << 31; // a
+    s1 ^= s1 >> 11; // b
+    s0 ^= s0 >> 30; // c
+    return ( s[ p ] = s0 ^ s1 ) * 1181783497276652981LL;
+}
+
+uint64_t getusertime() {
+	struct rusage rusage;
+	getrusage( 0, &rusage );
+	return rusage.ru_utime.tv_sec * 1000000ULL + rusage.ru_utime.tv_usec;
+}
+
+int main( int argc, char *argv[] ) {
+	if ( argc < 5 ) {
+		fprintf( stderr, "Usage: %s UNIVERSE NUMTERMS NUMQUERIES TERMSPERQUERY [MAXDENSITY]\n", argv[ 0 ] );
+		return 0;
+	}
+
+	const uint64_t universe = strtoll( argv[ 1 ], NULL, 0 );
+	const int num_terms = atoi( argv[ 2 ] ), num_queries = atoi( argv[ 3 ] ), terms_per_query = atoi( argv[ 4 ] );
+	const double max_density = argc > 5 ? atof( argv[ 5 ] ) : 0.1;
+	assert( terms_per_query <= num_terms );
+
+	// Term t has a list of about universe * max_density / ( t + 1 ) documents (Zipf's law with exponent 1).
+	vector<vector<uint64_t> > postings( num_terms );
+	vector<elias_fano *> lists( num_terms );
+	vector<double> cumulative( num_terms );
+	uint64_t total = 0;
+
+	for( int t = 0; t < num_terms; t++ ) {
+		const uint64_t df = max( (uint64_t)1, (uint64_t)( universe * max_density / ( t + 1 ) ) );
+		vector<uint64_t> &p = postings[ t ];
+		for( uint64_t i = 0; i < df; i++ ) p.push_back( xrand() % universe );
+		sort( p.begin(), p.end() );
+		p.erase( unique( p.begin(), p.end() ), p.end() );
+		lists[ t ] = new elias_fano( &p[ 0 ], p.size(), universe );
+		total += p.size();
+		cumulative[ t ] = ( t == 0 ? 0 : cumulative[ t - 1 ] ) + 1.0 / ( t + 1 );
+	}
+
+	printf( "Terms: %d postings: %lld\n", num_terms, total );
+
+	// Query terms are distinct and drawn with the same Zipfian distribution.
+	vector<vector<elias_fano *> > queries( num_queries );
+	vector<vector<int> > query_terms( num_queries );
+	for( int q = 0; q < num_queries; q++ )
+		while( query_terms[ q ].size() < terms_per_query ) {
+			const double x = ( xrand() >> 11 ) * ( 1.0 / ( 1ULL << 53 ) ) * cumulative[ num_terms - 1 ];
+			const int t = lower_bound( cumulative.begin(), cumulative.end(), x ) - cumulative.begin();
+			if ( find( query_terms[ q ].begin(), query_terms[ q ].end(), t ) != query_terms[ q ].end() ) continue;
+			query_terms[ q ].push_back( t );
+			queries[ q ].push_back( lists[ t ] );
+		}
+
+	uint64_t * const out = new uint64_t[ total ];
+	uint64_t results = 0, dummy = 0;
+	int64_t start, elapsed;
+	double s;
+
+	start = getusertime();
+
+	for( int q = 0; q < num_queries; q++ ) {
+		const uint64_t n = intersect_lists( &queries[ q ][ 0 ], terms_per_query, out );
+		results += n;
+		dummy ^= n ? out[ n - 1 ] : 0;
+	}
+
+	elapsed = getusertime() - start;
+	s = elapsed / 1E6;
+	printf( "%f s, %f us/intersection, %lld results\n", s, 1E6 * s / num_queries, results );
+
+	results = 0;
+	start = getusertime();
+
+	for( int q = 0; q < num_queries; q++ ) {
+		const uint64_t n = unite_lists( &queries[ q ][ 0 ], terms_per_query, out );
+		results += n;
+		dummy ^= n ? out[ n - 1 ] : 0;
+	}
+
+	elapsed = getusertime() - start;
+	s = elapsed / 1E6;
+	printf( "%f s, %f us/union, %f ns/result, %lld results\n", s, 1E6 * s / num_queries, 1E9 * s / results, results );
+
+#ifndef NDEBUG
+	for( int q = 0; q < num_queries; q++ ) {
+		vector<uint64_t> expected_and = postings[ query_terms[ q ][ 0 ] ], expected_or = expected_and, t;
+		for( int i = 1; i < terms_per_query; i++ ) {
+			const vector<uint64_t> &p = postings[ query_terms[ q ][ i ] ];
+			t.clear();
+			set_intersection( expected_and.begin(), expected_and.end(), p.begin(), p.end(), back_inserter( t ) );
+			expected_and.swap( t );
+			t.clear();
+			set_union( expected_or.begin(), expected_or.end(), p.begin(), p.end(), back_inserter( t ) );
+			expected_or.swap( t );
+		}
+
+		uint64_t n = intersect_lists( &queries[ q ][ 0 ], terms_per_query, out );
+		assert( n == expected_and.size() && equal( expected_and.begin(), expected_and.end(), out ) );
+		n = unite_lists( &queries[ q ][ 0 ], terms_per_query, out );
+		assert( n == expected_or.size() && equal( expected_or.begin(), expected_or.end(), out ) );
+	}
+#endif
+
+	for( int t = 0; t < num_terms; t++ ) delete lists[ t ];
+	delete [] out;
+	if ( !dummy ) putchar(0); // To avoid excision
+
+	return 0;
+}
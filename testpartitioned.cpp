@@ -0,0 +1,122 @@
+/*		 
+ * Sux: Succinct data structures
+ *
+ * Copyright (C) 2007-2013 Sebastiano Vigna 
+ *
+ *  This library is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published by the Free
+ *  Software Foundation; either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  This library is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+using namespace std;
+
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <vector>
+#include "elias_fano.h"
+#include "partitioned_elias_fano.h"
+#include "posrep.h"
+
+static uint64_t s[ 16 ] = {
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
+	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL
+};
+
+static uint64_t __inline xrand(void) {
+    static int p;
+    uint64_t s0 = s[ p ];
+    uint64_t s1 = s[ p = ( p + 1 ) & 15 ];
+    s1 ^= s1 << 31; // a
+    s1 ^= s1 >> 11; // b
+    s0 ^= s0 >> 30; // c
+    return ( s[ p ] = s0 ^ s1 ) * 1181783497276652981LL;
+}
+
+uint64_t getusertime() {
+	struct rusage rusage;
+	getrusage( 0, &rusage );
+	return rusage.ru_utime.tv_sec * 1000000ULL + rusage.ru_utime.tv_usec;
+}
+
+#define TIME( name, what ) \
+	start = getusertime(); \
+	for( int k = REPEATS; k-- != 0; ) for( int i = 0; i < POSITIONS; i++ ) what; \
+	elapsed = getusertime() - start; \
+	s = elapsed / 1E6; \
+	printf( "%-36s %f ns/query\n", name, 1E9 * s / (REPEATS * POSITIONS) );
+
+int main( int argc, char *argv[] ) {
+	if ( argc < 2 ) {
+		fprintf( stderr, "Usage: %s UNIVERSE [CLUSTERLENGTH]\n", argv[ 0 ] );
+		return 0;
+	}
+
+	const uint64_t universe = strtoll( argv[ 1 ], NULL, 0 );
+	const uint64_t cluster_length = argc > 2 ? strtoll( argv[ 2 ], NULL, 0 ) : 1000;
+
+	// Clustered document identifiers: dense clusters and runs separated by sparse gaps
+	vector<uint64_t> values;
+	for( uint64_t pos = 0; pos < universe; ) {
+		const uint64_t length = 1 + xrand() % ( 2 * cluster_length );
+		const int kind = xrand() % 3;
+		const uint64_t gap_length = kind == 2 ? length * 10 : length;
+		const uint64_t threshold = kind == 0 ? -1ULL : kind == 1 ? -1ULL / 10 * 7 : -1ULL / 1000;
+		for( uint64_t i = 0; i < gap_length && pos < universe; i++, pos++ ) if ( xrand() <= threshold ) values.push_back( pos );
+	}
+
+	const uint64_t num_values = values.size();
+	printf( "Universe: %lld values: %lld\n", universe, num_values );
+	assert( num_values != 0 );
+
+	elias_fano ef( &values[ 0 ], num_values, universe );
+	partitioned_elias_fano pef( &values[ 0 ], num_values, universe );
+
+	printf( "elias_fano: %f bits/value\n", ef.bit_count() / (double)num_values );
+	printf( "partitioned_elias_fano: %f bits/value\n", pef.bit_count() / (double)num_values );
+
+	uint64_t * const position = new uint64_t[ POSITIONS ], * const rank = new uint64_t[ POSITIONS ];
+	for( int i = 0; i < POSITIONS; i++ ) {
+		position[ i ] = xrand() % universe;
+		rank[ i ] = xrand() % num_values;
+	}
+
+	uint64_t dummy = 0, index;
+	int64_t start, elapsed;
+	double s;
+
+	TIME( "elias_fano::select", dummy ^= ef.select( rank[ i ] ) );
+	TIME( "partitioned_elias_fano::select", dummy ^= pef.select( rank[ i ] ) );
+	TIME( "elias_fano::rank", dummy ^= ef.rank( position[ i ] ) );
+	TIME( "partitioned_elias_fano::rank", dummy ^= pef.rank( position[ i ] ) );
+	TIME( "elias_fano::next_geq", dummy ^= ef.next_geq( position[ i ], &index ) );
+	TIME( "partitioned_elias_fano::next_geq", dummy ^= pef.next_geq( position[ i ], &index ) );
+
+	for( int i = 0; i < POSITIONS; i++ ) {
+		uint64_t index0, index1;
+		assert( pef.select( rank[ i ] ) == values[ rank[ i ] ] );
+		assert( pef.rank( position[ i ] ) == ef.rank( position[ i ] ) );
+		assert( pef.next_geq( position[ i ], &index0 ) == ef.next_geq( position[ i ], &index1 ) && index0 == index1 );
+	}
+
+	delete [] position;
+	delete [] rank;
+	if ( !dummy ) putchar(0); // To avoid excision
+
+	return 0;
+}
@@ -29,14 +29,28 @@ using namespace std;
 #include <limits.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include "rank9.h"
+#include "interleaved_rank9.h"
+#include "poppy.h"
 #include "rank9sel.h"
+#include "rank9sel01.h"
 #include "rank9b.h"
 #include "jacobson.h"
+#include "rrr.h"
+#include "hybrid_bit_vector.h"
+#include "run_length_bit_vector.h"
 #include "elias_fano.h"
 #include "simple_select.h"
 #include "simple_rank.h"
 #include "simple_select_half.h"
+#include "simple_select_zero.h"
 #include "posrep.h"
+#include "serialize.h"
+#include "mapped_bit_vector.h"
+#include "allocator.h"
 
 static uint64_t s[ 16 ] = {
 	0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 0xAAAAAAAAAAAAAAAAULL, 
@@ -66,39 +80,120 @@ int main( int argc, char *argv[] ) {
 	assert( sizeof(int) == 4 );
 
 	if ( argc < 3 ) {
-		fprintf( stderr, "Usage: %s NUMBITS DENSITY0 [DENSITY1]\n", argv[ 0 ] );
+		fprintf( stderr, "Usage: %s NUMBITS DENSITY0 [DENSITY1]\n       %s -f FILE\n", argv[ 0 ], argv[ 0 ] );
 		return 0;
 	}
 
-	const int64_t num_bits = strtoll( argv[ 1 ], NULL, 0 );
-	printf( "Number of bits: %lld\n", num_bits );
-	printf( "Number of words: %lld\n", num_bits / 64 );
-	printf( "Number of blocks: %lld\n", ( num_bits / 64 ) / 16 );
-	uint64_t * const bits = (uint64_t *)calloc( num_bits / 64 + 1, sizeof *bits );
+	int64_t num_bits;
+	const uint64_t *bits;
+	uint64_t num_ones_first_half = 0, num_ones_second_half = 0;
+	mapped_bit_vector *mapped = NULL;
 
-	double density0 = atof( argv[ 2 ] ), density1 = argc > 3 ? atof( argv[ 3 ] ) : density0;
-	assert( density0 >= 0 );
-	assert( density0 <= 1 );
-	assert( density1 >= 0 );
-	assert( density1 <= 1 );
+	if ( strcmp( argv[ 1 ], "-f" ) == 0 ) {
+		// Bit vector from disk, paged in by the kernel
+		mapped = new mapped_bit_vector( argv[ 2 ] );
+		if ( ! mapped->ok() ) return 1;
+		bits = mapped->bits();
+		num_bits = mapped->num_bits();
+		mapped->advise_sequential();
 
-	// Init array with given density
-	const uint64_t threshold0 = (uint64_t)((UINT64_MAX) * density0), threshold1 = (uint64_t)((UINT64_MAX) * density1);
+		for( int64_t i = 0; i < num_bits / 64; i++ ) num_ones_second_half += __builtin_popcountll( bits[ i ] );
+		if ( num_bits % 64 != 0 ) num_ones_second_half += __builtin_popcountll( bits[ num_bits / 64 ] & ( 1ULL << num_bits % 64 ) - 1 );
+		for( int64_t i = 0; i < num_bits / 2 / 64; i++ ) num_ones_first_half += __builtin_popcountll( bits[ i ] );
+		if ( num_bits / 2 % 64 != 0 ) num_ones_first_half += __builtin_popcountll( bits[ num_bits / 2 / 64 ] & ( 1ULL << num_bits / 2 % 64 ) - 1 );
+		num_ones_second_half -= num_ones_first_half;
+	}
+	else {
+		num_bits = strtoll( argv[ 1 ], NULL, 0 );
+		// With -DHUGEPAGES the bits, too, are backed by huge pages
+		uint64_t * const generated = (uint64_t *)default_allocator().allocate( ( num_bits / 64 + 1 ) * sizeof *generated );
 
-	uint64_t num_ones_first_half = 0, num_ones_second_half = 0;
+		double density0 = atof( argv[ 2 ] ), density1 = argc > 3 ? atof( argv[ 3 ] ) : density0;
+		assert( density0 >= 0 );
+		assert( density0 <= 1 );
+		assert( density1 >= 0 );
+		assert( density1 <= 1 );
+
+		// Init array with given density
+		const uint64_t threshold0 = (uint64_t)((UINT64_MAX) * density0), threshold1 = (uint64_t)((UINT64_MAX) * density1);
 
-	for( int64_t i = 0; i < num_bits / 2; i++ ) if ( xrand() < threshold0 ) { num_ones_first_half++; bits[ i / 64 ] |= 1LL << i % 64; }
-	for( int64_t i = num_bits / 2; i < num_bits; i++ ) if ( xrand() < threshold1 ) { num_ones_second_half++; bits[ i / 64 ] |= 1LL << i % 64; }
+#ifdef RUNS
+		// Each bit repeats the previous one, except that with probability 1/RUNS it is drawn anew,
+		// so ones and zeroes come in runs of about RUNS bits with the same density.
+		bool bit = false;
+		for( int64_t i = 0; i < num_bits / 2; i++ ) {
+			if ( xrand() % RUNS == 0 ) bit = xrand() < threshold0;
+			if ( bit ) { num_ones_first_half++; generated[ i / 64 ] |= 1LL << i % 64; }
+		}
+		for( int64_t i = num_bits / 2; i < num_bits; i++ ) {
+			if ( xrand() % RUNS == 0 ) bit = xrand() < threshold1;
+			if ( bit ) { num_ones_second_half++; generated[ i / 64 ] |= 1LL << i % 64; }
+		}
+#else
+		for( int64_t i = 0; i < num_bits / 2; i++ ) if ( xrand() < threshold0 ) { num_ones_first_half++; generated[ i / 64 ] |= 1LL << i % 64; }
+		for( int64_t i = num_bits / 2; i < num_bits; i++ ) if ( xrand() < threshold1 ) { num_ones_second_half++; generated[ i / 64 ] |= 1LL << i % 64; }
+#endif
+		bits = generated;
+	}
+
+	printf( "Number of bits: %lld\n", num_bits );
+	printf( "Number of words: %lld\n", num_bits / 64 );
+	printf( "Number of blocks: %lld\n", ( num_bits / 64 ) / 16 );
 
 #ifdef DEBUG
 	printf("First words: %016llx %016llx %016llx %016llx\n", bits[ 0 ], bits[ 1 ], bits[ 2 ], bits[ 3 ] );
 #endif
 
-#ifdef MAX_LOG2_LONGWORDS_PER_SUBINVENTORY
+#ifdef VALUES
+	// Build from the sorted positions of the ones instead of the bit vector
+	uint64_t * const values = (uint64_t *)calloc( num_ones_first_half + num_ones_second_half + 1, sizeof *values );
+	uint64_t num_values = 0;
+	for( int64_t i = 0; i < num_bits; i++ ) if ( bits[ i / 64 ] & 1ULL << i % 64 ) values[ num_values++ ] = i;
+	CLASS rs( values, num_values, num_bits );
+	free( values );
+#elif defined( MAX_LOG2_LONGWORDS_PER_SUBINVENTORY )
 	CLASS rs( bits, num_bits, MAX_LOG2_LONGWORDS_PER_SUBINVENTORY );
 #else
 	CLASS rs( bits, num_bits );
 #endif
+	// From now on, queries touch the bit vector at random positions
+	if ( mapped != NULL ) mapped->advise_random();
+
+#ifdef SERIALIZE
+	// Save the structure, map it back and check that the loaded copy answers like the original.
+	char path[] = "/tmp/testrankselXXXXXX";
+	FILE * const file = fdopen( mkstemp( path ), "w" );
+	sux_writer writer( file );
+	rs.save( writer );
+	fclose( file );
+
+	int64_t load_start = getusertime();
+	sux_mapped_file mapping( path );
+	assert( mapping.ok() );
+	sux_reader reader = mapping.reader();
+#ifdef SELF_CONTAINED
+	CLASS loaded( reader );
+#else
+	CLASS loaded( bits, reader );
+#endif
+	printf( "Saved %lld bytes, loaded in %f s\n", mapping.size(), ( getusertime() - load_start ) / 1E6 );
+	unlink( path );
+
+	for( int i = 0; i < 1000000; i++ ) {
+		const uint64_t p = xrand() % num_bits;
+#ifndef NORANKTEST
+		assert( loaded.rank( p ) == rs.rank( p ) );
+#endif
+#ifndef NOSELECTTEST
+		const uint64_t r = p % ( num_ones_first_half + num_ones_second_half + 1 );
+		if ( r < num_ones_first_half + num_ones_second_half ) assert( loaded.select( r ) == rs.select( r ) );
+#endif
+#ifdef SELECTZERO
+		const uint64_t z = p % ( num_bits - num_ones_first_half - num_ones_second_half + 1 );
+		if ( z < num_bits - num_ones_first_half - num_ones_second_half ) assert( loaded.select_zero( z ) == rs.select_zero( z ) );
+#endif
+	}
+#endif
 
 	int64_t dummy = 0x12345678; // Just to keep the compiler from excising code.
 
@@ -119,12 +214,109 @@ int main( int argc, char *argv[] ) {
 
 	for( int k = REPEATS; k-- != 0; )
 		for( int i = 0; i < POSITIONS; i++ )
+#ifdef LATENCY
+			// Each query depends on the previous one, so that cache misses cannot overlap
+			dummy = rs.rank( position[ i ] ^ ( dummy & 1 ) );
+#else
 			dummy ^= rs.rank( position[ i ] );
+#endif
 
 
 	elapsed = getusertime() - start;
 	s = elapsed / 1E6;
 	printf( "%f s, %f ranks/s, %f ns/rank\n", s, (REPEATS * POSITIONS) / s, 1E9 * s / (REPEATS * POSITIONS) );
+
+#ifdef BATCH
+	uint64_t * const result = (uint64_t *)calloc( POSITIONS, sizeof *result );
+
+	start = getusertime();
+
+	for( int k = REPEATS; k-- != 0; ) {
+		rs.rank_batch( position, POSITIONS, result );
+		dummy ^= result[ k ];
+	}
+
+	elapsed = getusertime() - start;
+	s = elapsed / 1E6;
+	printf( "%f s, %f ranks/s, %f ns/rank [batch]\n", s, (REPEATS * POSITIONS) / s, 1E9 * s / (REPEATS * POSITIONS) );
+
+	for( int i = 0; i < POSITIONS; i++ ) assert( result[ i ] == rs.rank( position[ i ] ) );
+	free( result );
+#endif
+
+#ifdef SUCCESSOR
+	uint64_t index;
+
+	start = getusertime();
+
+	for( int k = REPEATS; k-- != 0; )
+		for( int i = 0; i < POSITIONS; i++ )
+			dummy ^= rs.next_geq( position[ i ], &index );
+
+	elapsed = getusertime() - start;
+	s = elapsed / 1E6;
+	printf( "%f s, %f next_geqs/s, %f ns/next_geq\n", s, (REPEATS * POSITIONS) / s, 1E9 * s / (REPEATS * POSITIONS) );
+
+	start = getusertime();
+
+	for( int k = REPEATS; k-- != 0; )
+		for( int i = 0; i < POSITIONS; i++ )
+			dummy ^= rs.prev_leq( position[ i ], &index );
+
+	elapsed = getusertime() - start;
+	s = elapsed / 1E6;
+	printf( "%f s, %f prev_leqs/s, %f ns/prev_leq\n", s, (REPEATS * POSITIONS) / s, 1E9 * s / (REPEATS * POSITIONS) );
+
+	for( int i = 0; i < POSITIONS; i++ ) {
+		const uint64_t r = rs.rank( position[ i ] ), t = rs.rank( position[ i ] + 1 );
+		assert( rs.next_geq( position[ i ], &index ) == ( r < num_ones_first_half + num_ones_second_half ? rs.select( r ) : num_bits ) );
+		assert( index == r );
+		assert( rs.prev_leq( position[ i ], &index ) == ( t > 0 ? rs.select( t - 1 ) : -1ULL ) );
+		assert( index == t - 1 );
+	}
+#endif
+
+#ifdef CURSOR
+	const uint64_t num_ones = num_ones_first_half + num_ones_second_half;
+
+	start = getusertime();
+
+	for( uint64_t i = 0; i < num_ones; i++ ) dummy ^= rs.select( i );
+
+	elapsed = getusertime() - start;
+	s = elapsed / 1E6;
+	printf( "%f s, %f values/s, %f ns/value [select]\n", s, num_ones / s, 1E9 * s / num_ones );
+
+	start = getusertime();
+
+	CLASS::cursor scan( rs );
+	for( uint64_t i = 0; i < num_ones; i++ ) {
+		dummy ^= scan.value();
+		scan.next();
+	}
+
+	elapsed = getusertime() - start;
+	s = elapsed / 1E6;
+	printf( "%f s, %f values/s, %f ns/value [cursor]\n", s, num_ones / s, 1E9 * s / num_ones );
+
+	CLASS::cursor check( rs );
+	for( uint64_t i = 0; i < num_ones; i++, check.next() ) assert( check.index() == i && check.value() == rs.select( i ) );
+	assert( check.value() == num_bits );
+
+	sort( position, position + POSITIONS );
+	CLASS::cursor skip( rs );
+	for( int i = 0; i < POSITIONS; i++ ) {
+		uint64_t index;
+		assert( skip.skip_to( position[ i ] ) == rs.next_geq( position[ i ], &index ) );
+		assert( skip.index() == index );
+	}
+
+	for( int i = 0; i < POSITIONS; i++ ) {
+		const uint64_t r = position[ i ] % ( num_ones + 1 );
+		assert( skip.move_to( r ) == ( r < num_ones ? rs.select( r ) : num_bits ) );
+		assert( skip.move_to( r + i % 300 ) == ( r + i % 300 < num_ones ? rs.select( r + i % 300 ) : num_bits ) );
+	}
+#endif
 #endif
 
 #ifndef NOSELECTTEST
@@ -136,17 +328,76 @@ int main( int argc, char *argv[] ) {
 
 		for( int k = REPEATS; k-- != 0; )
 			for( int i = 0; i < POSITIONS; i++ )
+#ifdef LATENCY
+				// Clearing a bit keeps the rank below the number of ones
+				dummy = rs.select( position[ i ] & ~( dummy & 1 ) );
+#else
 				dummy ^= rs.select( position[ i ] );
+#endif
 
 		elapsed = getusertime() - start;
 		s = elapsed / 1E6;
 		printf( "%f s, %f selects/s, %f ns/select\n", s, (REPEATS * POSITIONS) / s, 1E9 * s / (REPEATS * POSITIONS) );
+
+#ifdef BATCH
+		uint64_t * const result = (uint64_t *)calloc( POSITIONS, sizeof *result );
+
+		start = getusertime();
+
+		for( int k = REPEATS; k-- != 0; ) {
+			rs.select_batch( position, POSITIONS, result );
+			dummy ^= result[ k ];
+		}
+
+		elapsed = getusertime() - start;
+		s = elapsed / 1E6;
+		printf( "%f s, %f selects/s, %f ns/select [batch]\n", s, (REPEATS * POSITIONS) / s, 1E9 * s / (REPEATS * POSITIONS) );
+
+		for( int i = 0; i < POSITIONS; i++ ) assert( result[ i ] == rs.select( position[ i ] ) );
+		free( result );
+#endif
 	}
 	else printf( "Too few ones to measure select speed\n" );
 #endif
 
+#ifdef SELECTZERO
+	const uint64_t num_zeroes = num_bits - num_ones_first_half - num_ones_second_half;
+
+	if ( num_zeroes != 0 ) {
+		for( int64_t i = POSITIONS; i-- != 0; ) position[ i ] = xrand() % num_zeroes;
+
+		start = getusertime();
+
+		for( int k = REPEATS; k-- != 0; )
+			for( int i = 0; i < POSITIONS; i++ )
+				dummy ^= rs.select_zero( position[ i ] );
+
+		elapsed = getusertime() - start;
+		s = elapsed / 1E6;
+		printf( "%f s, %f selects/s, %f ns/select zero\n", s, (REPEATS * POSITIONS) / s, 1E9 * s / (REPEATS * POSITIONS) );
+
+		// For comparison, a separate structure for zeroes
+		simple_select_zero ssz( bits, num_bits, 2 );
+		printf( "simple_select_zero bit cost: %lld (%.2f%%)\n", ssz.bit_count(), (ssz.bit_count()*100.0)/num_bits );
+
+		start = getusertime();
+
+		for( int k = REPEATS; k-- != 0; )
+			for( int i = 0; i < POSITIONS; i++ )
+				dummy ^= ssz.select_zero( position[ i ] );
+
+		elapsed = getusertime() - start;
+		s = elapsed / 1E6;
+		printf( "%f s, %f selects/s, %f ns/select zero [simple_select_zero]\n", s, (REPEATS * POSITIONS) / s, 1E9 * s / (REPEATS * POSITIONS) );
+
+		for( int i = 0; i < 1000000; i++ ) assert( rs.select_zero( position[ i ] ) == ssz.select_zero( position[ i ] ) );
+	}
+	else printf( "Too few zeroes to measure select zero speed\n" );
+#endif
+
 	rs.print_counts();
 	if ( !dummy ) putchar(0); // To avoid excision
 
+	delete mapped;
 	return 0;
 }
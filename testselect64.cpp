@@ -54,26 +54,10 @@ long long getusertime() {
 	return rusage.ru_utime.tv_sec * 1000000L + rusage.ru_utime.tv_usec;
 }
 
-__inline int select_in_word_bw( const uint64_t x, const int k ) {
-	// Phase 1: sums by byte
-	uint64_t byte_sums = x - ( x >> 1 & 0x5ULL * ONES_STEP_4 );
-	byte_sums = ( byte_sums & 3ULL * ONES_STEP_4 ) + ( ( byte_sums >> 2 ) & 3ULL * ONES_STEP_4 );
-	byte_sums = ( byte_sums + ( byte_sums >> 4 ) ) & 0x0fULL * ONES_STEP_8;
-	byte_sums *= ONES_STEP_8;
-
-	// Phase 2: compare each byte sum with k
-	const uint64_t k_step_8 = k * ONES_STEP_8;
-	// Giuseppe Ottaviano's improvement
-	const int place = __builtin_popcountll( EASY_LEQ_STEP_8_MSBS( byte_sums, k_step_8 ) ) * 8;
-
-	// Phase 3: Locate the relevant byte and look up the result in select_in_byte
-	return place + select_in_byte[ x >> place & 0xFFULL | k - ( ( byte_sums << 8 ) >> place & 0xFFULL ) << 8 ];
-}
-
 // Borrowed from Philip Pronin's code for Facebook's folly library.
 __inline int select_in_word_ctzll( uint64_t x, int rank ) {
 #ifndef NDEBUG
-	int result = select_in_word_bw( x, rank );
+	int result = select_in_word_broadword( x, rank );
 #endif
 	const int half_count = __builtin_popcountll(x);
 	if( rank >= half_count ) {
@@ -89,7 +73,7 @@ __inline int select_in_word_ctzll( uint64_t x, int rank ) {
 
 __inline int select_in_word_popcount( const uint64_t x, const int k ) {
 #ifndef NDEBUG
-	int result = select_in_word_bw( x, k );
+	int result = select_in_word_broadword( x, k );
 #endif
 
 	for( int i = 0, c = k; i < 64; i+=8 )
@@ -104,7 +88,7 @@ __inline int select_in_word_popcount( const uint64_t x, const int k ) {
 
 __inline int select_gog_petri( uint64_t x, int i ) {
 #ifndef NDEBUG
-	int result = select_in_word_bw( x, i );
+	int result = select_in_word_broadword( x, i );
 #endif
 
 	uint64_t s = x, b;
@@ -131,7 +115,7 @@ __inline int select_gog_petri( uint64_t x, int i ) {
 
 __inline int select_gog_petri2( const uint64_t x, const int i ) {
 #ifndef NDEBUG
-	int result = select_in_word_bw( x, i );
+	int result = select_in_word_broadword( x, i );
 #endif
 
 	// Phase 1: sums by byte
@@ -150,6 +134,23 @@ __inline int select_gog_petri2( const uint64_t x, const int i ) {
 	return place + select_in_byte[ x >> place & 0xFFULL | ( i - ( ( byte_sums << 8 ) >> place & 0xFF ) ) << 8 ];
 }
 
+#define NUM_WORDS ( POSITIONS / 10 )
+#define RANKS_PER_WORD 10
+
+// Times a select-in-word variant on the current words and ranks.
+#define BENCH( name, select ) { \
+	start = getusertime(); \
+	for( int k = REPEATS; k-- != 0; ) \
+		for( int i = NUM_WORDS; i-- != 0; ) { \
+			const uint64_t w = word[ i ]; \
+			const int * const r = &rank[ i * RANKS_PER_WORD ]; \
+			for( int j = 0; j < RANKS_PER_WORD; j++ ) dummy ^= select( w, r[ j ] ); \
+		} \
+	elapsed = getusertime() - start; \
+	s = elapsed / 1E6; \
+	printf( "%f s, %f selects/s, %f ns/select [" name "]\n", s, ( (double)REPEATS * NUM_WORDS * RANKS_PER_WORD ) / s, 1E9 * s / ( (double)REPEATS * NUM_WORDS * RANKS_PER_WORD ) ); \
+}
+
 int main( int argc, char *argv[] ) {
 	assert( sizeof(int) == 4 );
 	assert( sizeof(long long) == 8 );
@@ -158,118 +159,39 @@ int main( int argc, char *argv[] ) {
 	double s;
 	int dummy = 0; // Just to keep the compiler from excising code.
 
-	uint64_t * const position = (uint64_t *)calloc( POSITIONS / 10, sizeof *position );
-	for( int i = POSITIONS / 10; i-- != 0; ) while( __builtin_popcountll( position[ i ] = xrand() ) < 32 ); // This shouldn't happen often
-	
-	start = getusertime();
-
-	for( int k = 10 * REPEATS; k-- != 0; ) {
-		for( int i = POSITIONS / 10; i-- != 0; ) {
-			const uint64_t w = position[ i ];
-			dummy ^= select_in_word_bw( w, 0 );
-			dummy ^= select_in_word_bw( w, 3 );
-			dummy ^= select_in_word_bw( w, 6 );
-			dummy ^= select_in_word_bw( w, 9 );
-			dummy ^= select_in_word_bw( w, 12 );
-			dummy ^= select_in_word_bw( w, 15 );
-			dummy ^= select_in_word_bw( w, 18 );
-			dummy ^= select_in_word_bw( w, 21 );
-			dummy ^= select_in_word_bw( w, 24 );
-			dummy ^= select_in_word_bw( w, 27 );
-		}
-	}
+	const double density[] = { 0.01, 0.05, 0.1, 0.25, 0.5, 0.75, 0.9 };
+	uint64_t * const word = (uint64_t *)calloc( NUM_WORDS, sizeof *word );
+	int * const rank = (int *)calloc( NUM_WORDS * RANKS_PER_WORD, sizeof *rank );
 
-	elapsed = getusertime() - start;
-	s = elapsed / 1E6;
-	printf( "%f s, %f selects/s, %f ns/select [broadword]\n", s, (10 * REPEATS * POSITIONS) / s, 1E9 * s / (10 * REPEATS * POSITIONS) );
-
-	start = getusertime();
-
-	for( int k = 10 * REPEATS; k-- != 0; ) {
-		for( int i = POSITIONS / 10; i-- != 0; ) {
-			const uint64_t w = position[ i ];
-			dummy ^= select_gog_petri( w, 0 );
-			dummy ^= select_gog_petri( w, 3 );
-			dummy ^= select_gog_petri( w, 6 );
-			dummy ^= select_gog_petri( w, 9 );
-			dummy ^= select_gog_petri( w, 12 );
-			dummy ^= select_gog_petri( w, 15 );
-			dummy ^= select_gog_petri( w, 18 );
-			dummy ^= select_gog_petri( w, 21 );
-			dummy ^= select_gog_petri( w, 24 );
-			dummy ^= select_gog_petri( w, 27 );
-		}
-	}
+#ifdef SELECT_IN_WORD_DISPATCH
+	printf( "Dispatched kernel: %s\n", select_in_word_kernel == SELECT_IN_WORD_BMI2 ? "BMI2" : "broadword" );
+#endif
 
-	elapsed = getusertime() - start;
-	s = elapsed / 1E6;
-	printf( "%f s, %f selects/s, %f ns/select [Gog & Petri]\n", s, (10 * REPEATS * POSITIONS) / s, 1E9 * s / (10 * REPEATS * POSITIONS) );
-
-	start = getusertime();
-
-	for( int k = 10 * REPEATS; k-- != 0; ) {
-		for( int i = POSITIONS / 10; i-- != 0; ) {
-			const uint64_t w = position[ i ];
-			dummy ^= select_gog_petri2( w, 0 );
-			dummy ^= select_gog_petri2( w, 3 );
-			dummy ^= select_gog_petri2( w, 6 );
-			dummy ^= select_gog_petri2( w, 9 );
-			dummy ^= select_gog_petri2( w, 12 );
-			dummy ^= select_gog_petri2( w, 15 );
-			dummy ^= select_gog_petri2( w, 18 );
-			dummy ^= select_gog_petri2( w, 21 );
-			dummy ^= select_gog_petri2( w, 24 );
-			dummy ^= select_gog_petri2( w, 27 );
-		}
-	}
+	for( int d = 0; d < sizeof density / sizeof *density; d++ ) {
+		const uint64_t threshold = (uint64_t)( UINT64_MAX * density[ d ] );
 
-	elapsed = getusertime() - start;
-	s = elapsed / 1E6;
-	printf( "%f s, %f selects/s, %f ns/select [Gog & Petri 2]\n", s, (10 * REPEATS * POSITIONS) / s, 1E9 * s / (10 * REPEATS * POSITIONS) );
-
-	start = getusertime();
-
-	for( int k = 10 * REPEATS; k-- != 0; ) {
-		for( int i = POSITIONS / 10; i-- != 0; ) {
-			const uint64_t w = position[ i ];
-			dummy ^= select_in_word_ctzll( w, 0 );
-			dummy ^= select_in_word_ctzll( w, 3 );
-			dummy ^= select_in_word_ctzll( w, 6 );
-			dummy ^= select_in_word_ctzll( w, 9 );
-			dummy ^= select_in_word_ctzll( w, 12 );
-			dummy ^= select_in_word_ctzll( w, 15 );
-			dummy ^= select_in_word_ctzll( w, 18 );
-			dummy ^= select_in_word_ctzll( w, 21 );
-			dummy ^= select_in_word_ctzll( w, 24 );
-			dummy ^= select_in_word_ctzll( w, 27 );
-		}
-	}
+		for( int i = NUM_WORDS; i-- != 0; ) {
+			do {
+				word[ i ] = 0;
+				for( int b = 0; b < 64; b++ ) if ( xrand() < threshold ) word[ i ] |= 1ULL << b;
+			} while( word[ i ] == 0 );
 
-	elapsed = getusertime() - start;
-	s = elapsed / 1E6;
-	printf( "%f s, %f selects/s, %f ns/select [prunin]\n", s, (10 * REPEATS * POSITIONS) / s, 1E9 * s / (10 * REPEATS * POSITIONS) );
-
-	start = getusertime();
-
-	for( int k = 10 * REPEATS; k-- != 0; ) {
-		for( int i = POSITIONS / 10; i-- != 0; ) {
-			const uint64_t w = position[ i ];
-			dummy ^= select_in_word_popcount( w, 0 );
-			dummy ^= select_in_word_popcount( w, 3 );
-			dummy ^= select_in_word_popcount( w, 6 );
-			dummy ^= select_in_word_popcount( w, 9 );
-			dummy ^= select_in_word_popcount( w, 12 );
-			dummy ^= select_in_word_popcount( w, 15 );
-			dummy ^= select_in_word_popcount( w, 18 );
-			dummy ^= select_in_word_popcount( w, 21 );
-			dummy ^= select_in_word_popcount( w, 24 );
-			dummy ^= select_in_word_popcount( w, 27 );
+			const int c = __builtin_popcountll( word[ i ] );
+			for( int j = 0; j < RANKS_PER_WORD; j++ ) rank[ i * RANKS_PER_WORD + j ] = xrand() % c;
 		}
-	}
 
-	elapsed = getusertime() - start;
-	s = elapsed / 1E6;
-	printf( "%f s, %f selects/s, %f ns/select [popcount]\n", s, (10 * REPEATS * POSITIONS) / s, 1E9 * s / (10 * REPEATS * POSITIONS) );
+		printf( "Density: %.2f\n", density[ d ] );
+
+		BENCH( "broadword", select_in_word_broadword );
+		BENCH( "Gog & Petri", select_gog_petri );
+		BENCH( "Gog & Petri 2", select_gog_petri2 );
+		BENCH( "prunin", select_in_word_ctzll );
+		BENCH( "popcount", select_in_word_popcount );
+#ifdef SELECT_IN_WORD_DISPATCH
+		if ( __builtin_cpu_supports( "bmi2" ) ) BENCH( "BMI2", select_in_word_bmi2 );
+#endif
+		BENCH( "dispatched", select_in_word );
+	}
 
 	if (!dummy) putchar(0); // To avoid excision
 